@@ -5,6 +5,7 @@
 #define ARCH_MSB_INDEX
 #define ARCH_LSB_INDEX
 #define ARCH_MUL_DIV_32
+#define ARCH_DIV_64_32
 
 /*!
  * Returns index of MSB (Most Significant Bit) that is not zero
@@ -50,3 +51,22 @@ static inline uint32 arch_mul_div_32 ( uint32 a, uint32 b, uint32 c )
 
 	return result; /* could also return remainder in 'mod' if required! */
 }
+
+/*!
+ * Divide 64-bit number with 32-bit one (without 64-bit division from libgcc)
+ * \param a	Dividend
+ * \param b	Divisor
+ * \param rem	Where to store remainder
+ * \return a / b (quotient must fit in 32 bits, i.e. a < b * 2^32)
+ */
+static inline uint32 arch_div_64_32 ( uint64 a, uint32 b, uint32 *rem )
+{
+	uint32 result, mod;
+
+	asm ("divl %2":"=a" (result), "=d" (mod):"rm" (b),
+		"0" ( (uint32) a ), "1" ( (uint32) ( a >> 32 ) ) );
+
+	*rem = mod;
+
+	return result;
+}
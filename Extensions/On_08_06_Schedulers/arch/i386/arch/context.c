@@ -7,24 +7,30 @@
 #include <arch/descriptors.h>
 #include <kernel/memory.h>
 
-/*! kernel (interrupt) stack */
-uint8 k_stack [ KERNEL_STACK_SIZE ];
+/*! kernel (interrupt) stacks, one per processor */
+uint8 k_stack [ MAX_CPUS ][ KERNEL_STACK_SIZE ];
 
-/*! interrupt handler stack */
-void *arch_interrupt_stack;
+/*! per processor data: interrupt stack, where is thread context saved */
+arch_cpu_t arch_cpus[MAX_CPUS];
 
-/*! where is thread context saved at interrupt? */
-uint32 arch_thr_context_ss;
-uint32 *arch_thr_context;
-
-/*! Set up context (normal and interrupt=kernel) */
+/*! Set up context (normal and interrupt=kernel) for boot processor */
 void arch_context_init ()
 {
-	arch_thr_context_ss = GDT_DESCRIPTOR ( SEGM_K_DATA, GDT, PRIV_KERNEL );
+	arch_cpu_init ( 0 );
+}
+
+/*! Set up context for processor 'cpu' (called on that processor) */
+void arch_cpu_init ( int cpu )
+{
+	arch_cpu_t *c = &arch_cpus[cpu];
 
-	arch_interrupt_stack = (void *) &k_stack [ KERNEL_STACK_SIZE ];
+	c->id = cpu;
+	c->thr_context_ss = GDT_DESCRIPTOR ( SEGM_K_DATA, GDT, PRIV_KERNEL );
+	c->thr_context = NULL;
+	c->interrupt_stack = (void *) &k_stack [ cpu ][ KERNEL_STACK_SIZE ];
+	c->new_mode = c->prev_mode = KERNEL_MODE;
 
-	arch_descriptors_init (); /* GDT, IDT, ... */
+	arch_descriptors_init ( cpu ); /* GDT, IDT, ... */
 }
 
 /*! context manipulation ---------------------------------------------------- */
@@ -67,7 +73,7 @@ void arch_create_thread_context ( context_t *context,
 /*! Select thread to return to from interrupt */
 inline void arch_select_thread ( context_t *context )
 {
-	arch_thr_context = (void *) &context->context;
+	arch_cpus[arch_cpu_id ()].thr_context = (void *) &context->context;
 	arch_tss_update(((void *) &context->context) + sizeof (arch_context_t));
 
 	/* update segment descriptors */
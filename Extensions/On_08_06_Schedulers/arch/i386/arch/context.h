@@ -2,8 +2,45 @@
 
 #pragma once
 
+/*! offsets of 'arch_cpu_t' elements (used in interrupts.S) */
+#define CPU_INTERRUPT_STACK	0
+#define CPU_THR_CONTEXT		4
+#define CPU_THR_CONTEXT_SS	8
+#define CPU_ID			12
+
+#ifndef ASM_FILE
+
 #include <lib/types.h>
 
+/*! Per processor data; segment SEGM_CPU (loaded in 'fs' while in kernel)
+    points to processor's element */
+typedef struct _arch_cpu_t_
+{
+	void *interrupt_stack;	/* interrupt handler stack */
+	uint32 *thr_context;	/* where is thread context saved at interrupt */
+	uint32 thr_context_ss;
+
+	int id;			/* processor index (0 for boot processor) */
+
+	int new_mode;		/* interrupted: user program or kernel */
+	int prev_mode;		/* (for tracking processor generated interrupts) */
+}
+arch_cpu_t;
+
+extern arch_cpu_t arch_cpus[MAX_CPUS];
+
+void arch_cpu_init ( int cpu );
+
+/*! Index of processor executing this code */
+static inline int arch_cpu_id ()
+{
+	int id;
+
+	asm ( "movl %%fs:%c1, %0" : "=r" (id) : "i" (CPU_ID) );
+
+	return id;
+}
+
 /*! context manipulation - for 'kernel threads'  ---------------------------- */
 
 #define	INIT_EFLAGS	0x3202 /* ring 3 ! */
@@ -98,3 +135,5 @@ static inline void arch_switch_to_uthread ( ucontext_t *from, ucontext_t *to )
 		: "=m" (from->esp) : "m" (to->esp)
 	);
 }
+
+#endif /* ASM_FILE */
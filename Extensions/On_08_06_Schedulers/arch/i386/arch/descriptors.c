@@ -4,44 +4,62 @@
 #include "descriptors.h"
 
 #include <arch/interrupts.h>
+#include <arch/context.h>
 #include <kernel/errno.h>
 
-/*! memory for GDT - Global Descriptor Table */
-static GDT_t gdt[] =
+/*! initial GDT - Global Descriptor Table */
+static GDT_t gdt_initial[GDT_SIZE] =
 {
 	GDT_0,
 	GDT_K_CODE, GDT_K_DATA,
 	GDT_T_CODE, GDT_K_DATA,
-	GDT_TSS
+	GDT_TSS,
+	GDT_K_DATA
 };
 
-/*! IDT */
+/*! memory for GDT - each processor has its own (user segments and TSS) */
+static GDT_t gdt[MAX_CPUS][GDT_SIZE];
+
+/*! IDT (shared by all processors) */
 static IDT_t idt[INTERRUPTS];
 
 /*! memory for TSS */
-static tss_t tss;
+static tss_t tss[MAX_CPUS];
 
 
-/*! Set up context (normal and interrupt=kernel) */
-void arch_descriptors_init ()
+/*! Set up context (normal and interrupt=kernel) for processor 'cpu' */
+void arch_descriptors_init ( int cpu )
 {
-	GDT_init ();
-	IDT_init ();
+	GDT_init ( cpu );
+	IDT_init ( cpu );
 }
 
 /*! Set up GDT */
-static void GDT_init ()
+static void GDT_init ( int cpu )
 {
 	GDTR_t gdtr;
+	int i;
 
-	/* initial update of segment descriptors */
-	arch_update_kernel_segments ( NULL, (size_t) 0xffffffff );
-	arch_update_user_segments ( NULL, (size_t) 0xffffffff );
-
-	arch_upd_segm_descr ( SEGM_TSS, &tss, sizeof(tss_t) - 1, PRIV_KERNEL );
+	for ( i = 0; i < GDT_SIZE; i++ )
+		gdt[cpu][i] = gdt_initial[i];
 
-	gdtr.gdt = gdt;
-	gdtr.limit = sizeof(gdt) - 1;
+	/* initial update of segment descriptors */
+	arch_upd_segm_descr ( cpu, SEGM_K_CODE, NULL, (size_t) 0xffffffff,
+			      PRIV_KERNEL );
+	arch_upd_segm_descr ( cpu, SEGM_K_DATA, NULL, (size_t) 0xffffffff,
+			      PRIV_KERNEL );
+	arch_upd_segm_descr ( cpu, SEGM_T_CODE, NULL, (size_t) 0xffffffff,
+			      PRIV_USER );
+	arch_upd_segm_descr ( cpu, SEGM_T_DATA, NULL, (size_t) 0xffffffff,
+			      PRIV_USER );
+
+	arch_upd_segm_descr ( cpu, SEGM_TSS, &tss[cpu], sizeof(tss_t) - 1,
+			      PRIV_KERNEL );
+	arch_upd_segm_descr ( cpu, SEGM_CPU, &arch_cpus[cpu],
+			      sizeof(arch_cpu_t), PRIV_KERNEL );
+
+	gdtr.gdt = gdt[cpu];
+	gdtr.limit = sizeof(gdt[cpu]) - 1;
 
 	/* load GDT address into register */
 	asm ( "lgdt	%0\n\t" :: "m" (gdtr) );
@@ -54,22 +72,24 @@ static void GDT_init ()
 			"mov	%1, %%eax	\n\t"
 			"mov	%%ax, %%ds	\n\t"
 			"mov	%%ax, %%es	\n\t"
-			"mov	%%ax, %%fs	\n\t"
 			"mov	%%ax, %%gs	\n\t"
 			"mov	%%ax, %%ss	\n\t"
+			"mov	%2, %%eax	\n\t"
+			"mov	%%ax, %%fs	\n\t"
 
 		:: "i" ( GDT_DESCRIPTOR ( SEGM_K_CODE, GDT, PRIV_KERNEL ) ),
-		   "i" ( GDT_DESCRIPTOR ( SEGM_K_DATA, GDT, PRIV_KERNEL ) )
-		: "memory"
+		   "i" ( GDT_DESCRIPTOR ( SEGM_K_DATA, GDT, PRIV_KERNEL ) ),
+		   "i" ( GDT_DESCRIPTOR ( SEGM_CPU, GDT, PRIV_KERNEL ) )
+		: "memory", "eax"
 	);
 
-	tss.ss0 = GDT_DESCRIPTOR ( SEGM_K_DATA, GDT, PRIV_KERNEL );
+	tss[cpu].ss0 = GDT_DESCRIPTOR ( SEGM_K_DATA, GDT, PRIV_KERNEL );
 	/* load TSS descriptor into TR */
 	asm ( "ltrw %w0\n\t" :: "r" GDT_DESCRIPTOR(SEGM_TSS, GDT, PRIV_KERNEL));
 }
 
-/*! Set up IDT */
-static void IDT_init ()
+/*! Set up IDT (boot processor fills it, others only load it) */
+static void IDT_init ( int cpu )
 {
 	/*! Interrupt handlers are defined in 'interrupts.S' */
 	extern uint32 arch_interrupt_handlers[INTERRUPTS];
@@ -78,7 +98,7 @@ static void IDT_init ()
 	uint32 offset;
 
 	/* fill IDT */
-	for ( i = 0; i < INTERRUPTS; i++ )
+	for ( i = 0; i < INTERRUPTS && cpu == 0; i++ )
 	{
 		offset = (uint32) arch_interrupt_handlers[i];
 
@@ -100,49 +120,56 @@ static void IDT_init ()
 	asm ( "lidt %0" : : "m" (idtr) );
 }
 
-/*! Update kernel segment descriptors in GDT */
+/*! Update kernel segment descriptors in GDT (of this processor) */
 void arch_update_kernel_segments ( void *kernel, size_t kernel_size )
 {
-	arch_upd_segm_descr ( SEGM_K_CODE, kernel, kernel_size, PRIV_KERNEL );
-	arch_upd_segm_descr ( SEGM_K_DATA, kernel, kernel_size, PRIV_KERNEL );
+	int cpu = arch_cpu_id ();
+
+	arch_upd_segm_descr ( cpu, SEGM_K_CODE, kernel, kernel_size,
+			      PRIV_KERNEL );
+	arch_upd_segm_descr ( cpu, SEGM_K_DATA, kernel, kernel_size,
+			      PRIV_KERNEL );
 }
 
-/*! Update user segment descriptors in GDT */
+/*! Update user segment descriptors in GDT (of this processor) */
 void arch_update_user_segments ( void *user, size_t user_size )
 {
-	arch_upd_segm_descr ( SEGM_T_CODE, user, user_size, PRIV_USER );
-	arch_upd_segm_descr ( SEGM_T_DATA, user, user_size, PRIV_USER );
+	int cpu = arch_cpu_id ();
+
+	arch_upd_segm_descr ( cpu, SEGM_T_CODE, user, user_size, PRIV_USER );
+	arch_upd_segm_descr ( cpu, SEGM_T_DATA, user, user_size, PRIV_USER );
 }
 
 /*! Update segment descriptor with starting address, size and privilege level */
-static void arch_upd_segm_descr ( int id, void *start_addr, size_t size,
-				  int priv_level )
+static void arch_upd_segm_descr ( int cpu, int id, void *start_addr,
+				  size_t size, int priv_level )
 {
+	GDT_t *gdt_cpu = gdt[cpu];
 	uint32 addr = (uint32) start_addr;
 	uint32 gsize = size;
 
-	ASSERT ( id > 0 && id <= 5 );
+	ASSERT ( id > 0 && id < GDT_SIZE );
 
-	gdt[id].base_addr0 =  addr & 0x0000ffff;
-	gdt[id].base_addr1 = (addr & 0x00ff0000) >> 16;
-	gdt[id].base_addr2 = (addr & 0xff000000) >> 24;
+	gdt_cpu[id].base_addr0 =  addr & 0x0000ffff;
+	gdt_cpu[id].base_addr1 = (addr & 0x00ff0000) >> 16;
+	gdt_cpu[id].base_addr2 = (addr & 0xff000000) >> 24;
 
 	if (size < (1 << 20)) { /* size < 1 MB? */
 		gsize = size - 1;
-		gdt[id].G = 0; /* granularity set to 1 byte */
+		gdt_cpu[id].G = 0; /* granularity set to 1 byte */
 	}
 	else {
 		gsize = size >> 12;
 		if (size & 0x0fff)
 			gsize++;
 		gsize--;
-		gdt[id].G = 1; /* granularity set to 4 KB */
+		gdt_cpu[id].G = 1; /* granularity set to 4 KB */
 	}
 
-	gdt[id].segm_limit0 =  gsize & 0x0000ffff;
-	gdt[id].segm_limit1 = (gsize & 0x000f0000) >> 16;
+	gdt_cpu[id].segm_limit0 =  gsize & 0x0000ffff;
+	gdt_cpu[id].segm_limit1 = (gsize & 0x000f0000) >> 16;
 
-	gdt[id].DPL = priv_level;
+	gdt_cpu[id].DPL = priv_level;
 }
 
 /*!
@@ -151,5 +178,5 @@ static void arch_upd_segm_descr ( int id, void *start_addr, size_t size,
  */
 void arch_tss_update ( void *context )
 {
-	tss.esp0 = (uint32) context;
+	tss[arch_cpu_id ()].esp0 = (uint32) context;
 }
@@ -8,6 +8,9 @@
 #define SEGM_T_CODE	3
 #define SEGM_T_DATA	4
 #define SEGM_TSS	5
+#define SEGM_CPU	6	/* per processor data (arch_cpu_t) */
+
+#define GDT_SIZE	7
 
 #define PRIV_KERNEL	0
 #define PRIV_USER	3
@@ -22,7 +25,7 @@
 
 #include <lib/types.h>
 
-void arch_descriptors_init ();
+void arch_descriptors_init ( int cpu );
 void arch_tss_update ( void *context );
 void arch_update_kernel_segments ( void *kernel, size_t kernel_size );
 void arch_update_user_segments ( void *user, size_t user_size );
@@ -216,8 +219,9 @@ typedef struct _tss_t_
 __attribute__((__packed__)) tss_t;
 
 
-static void GDT_init ();
-static void IDT_init ();
-static void arch_upd_segm_descr (int id, void *start, size_t size, int priv);
+static void GDT_init ( int cpu );
+static void IDT_init ( int cpu );
+static void arch_upd_segm_descr ( int cpu, int id, void *start, size_t size,
+				  int priv );
 
 #endif /* _ARCH_DESCRIPTORS_C_ */
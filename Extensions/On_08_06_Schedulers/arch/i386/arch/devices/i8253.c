@@ -11,8 +11,8 @@
 /*! timer device i8253, wrapper for arch_timer_t interface */
 arch_timer_t i8253 = (arch_timer_t)
 {
-	.min_interval = { 0, 0 },
-	.max_interval = { 0, 0 },
+	.min_interval = 0,
+	.max_interval = 0,
 	.init = i8253_init,
 	.set_interval = i8253_set_time_to_counter,
 	.get_interval_remainder = i8253_get_time_from_counter,
@@ -25,8 +25,8 @@ arch_timer_t i8253 = (arch_timer_t)
 /*! Calculate min and max counting interval, and set initial counter */
 static void i8253_init ()
 {
-	COUNT_TO_TIME ( COUNT_MIN, &i8253.min_interval );
-	COUNT_TO_TIME ( COUNT_MAX, &i8253.max_interval );
+	COUNT_TO_TIME ( COUNT_MIN, i8253.min_interval );
+	COUNT_TO_TIME ( COUNT_MAX, i8253.max_interval );
 
 	i8253_set ( COUNT_MAX );
 }
@@ -58,29 +58,28 @@ static uint i8253_get ()
 }
 
 /*! Load counter with number equivalent to 'time' */
-static void i8253_set_time_to_counter ( time_t *time )
+static void i8253_set_time_to_counter ( ktime_t time )
 {
 	uint cnt;
 
-	ASSERT ( time && time->sec == 0 &&
-		 time->nsec <= i8253.max_interval.nsec &&
-		 time->nsec >= i8253.min_interval.nsec );
+	ASSERT ( time <= i8253.max_interval && time >= i8253.min_interval );
 
 	TIME_TO_COUNT ( time, cnt );
 
 	i8253_set ( cnt );
 }
 
-/*! Read current value from counter and convert it into 'time' */
-static void i8253_get_time_from_counter ( time_t *time )
+/*! Read current value from counter and convert it into time */
+static ktime_t i8253_get_time_from_counter ()
 {
 	uint cnt;
-
-	ASSERT ( time );
+	ktime_t time;
 
 	cnt = i8253_get();
 
 	COUNT_TO_TIME ( cnt, time );
+
+	return time;
 }
 
 /*! Enable counter interrupts */
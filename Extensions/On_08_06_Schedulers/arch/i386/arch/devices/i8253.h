@@ -9,23 +9,25 @@
 #include <lib/types.h>
 
 #define	I8253_FREQ	1193180 /* counter frequency */
-#define N1E9		1000000000L
+#define N1E9		1000000000ULL
 
 #define COUNT_MAX	0xffff
 #define COUNT_MIN	( COUNT_MAX >> 10 )
 
-/* Calculate time from counter value */
+/* fixed point factors (calculated by compiler): nanoseconds per count
+   scaled by 2^16 and counts per nanosecond scaled by 2^32 */
+#define NSEC_PER_COUNT	( ( N1E9 << 16 ) / I8253_FREQ )
+#define COUNT_PER_NSEC	( ( ( (uint64) I8253_FREQ ) << 32 ) / N1E9 )
+
+/* Calculate time (nanoseconds) from counter value */
 #define COUNT_TO_TIME(C, T)	\
-do { (T)->sec = 0; (T)->nsec = mul_div_32 ( C, N1E9, I8253_FREQ ); } while(0)
-/* generally would be:
-	T.sec = C / I8253_FREQ; //but is zero because max(C) < I8253_FREQ!
-	T.nsec = (C % I8253_FREQ) * 1.E9 / I8253_FREQ; */
+do { T = ( (uint64) (C) * (uint32) NSEC_PER_COUNT ) >> 16; } while(0)
+/* generally would be: C * 1.E9 / I8253_FREQ */
 
-/* Calculate counter value from time */
+/* Calculate counter value from time (interval is always below one second) */
 #define TIME_TO_COUNT(T, C) \
-do { C = mul_div_32 ( (T)->nsec, I8253_FREQ, N1E9 ); } while(0)
-/* generally would be: (T->sec + T->nsec / 1.E9) * I8253_FREQ, but since T->sec
-   must be zero its little simpler: T->nsec * I8253_FREQ / 1.E9 */
+do { C = ( (uint64) (uint32) (T) * (uint32) COUNT_PER_NSEC ) >> 32; } while(0)
+/* generally would be: T * I8253_FREQ / 1.E9 */
 
 
 /* i8253 ports and commands */
@@ -44,7 +46,7 @@ static void i8253_disable_interrupt ();
 
 static void i8253_register_interrupt ( void *handler );
 
-static void i8253_set_time_to_counter ( time_t *time );
-static void i8253_get_time_from_counter ( time_t *time );
+static void i8253_set_time_to_counter ( ktime_t time );
+static ktime_t i8253_get_time_from_counter ();
 
 #endif /* I8253 */
@@ -160,7 +160,7 @@ static char *arch_int_desc[] =
  */
 static char *i8259_interrupt_description ( unsigned int n )
 {
-	if ( n < INTERRUPTS )
+	if ( n < sizeof (arch_int_desc) / sizeof (char *) )
 		return arch_int_desc[n];
 	else
 		return "Unknown interrupt number";
@@ -0,0 +1,237 @@
+/*! Local APIC timer (timer device) */
+#ifdef LAPIC_TIMER
+
+/*!
+ * Timer of boot processor local APIC, used instead of i8253 (TIMER=lapic_timer
+ * in Makefile). When processor supports it, TSC-deadline mode is used: timer
+ * expires when time stamp counter reaches value written to MSR, so setting
+ * interval is single 'wrmsr'. Otherwise timer counts down from initial count
+ * (bus clock / 16) in periodic mode, restarting when it expires, as i8253.
+ * Both frequencies are measured with i8253 in 'init'. Intervals are up to
+ * LT_MAX_INTERVAL, instead of ~55 ms with i8253.
+ */
+
+#include "lapic_timer.h"
+
+#include <arch/interrupts.h>
+#include <arch/processor.h>
+
+#include <kernel/errno.h>
+
+/*! timer device local APIC timer, wrapper for arch_timer_t interface */
+arch_timer_t lapic_timer = (arch_timer_t)
+{
+	.min_interval = 0,
+	.max_interval = 0,
+	.init = lapic_timer_init,
+	.set_interval = lapic_timer_set_time_to_counter,
+	.get_interval_remainder = lapic_timer_get_time_from_counter,
+	.enable_interrupt = lapic_timer_enable_interrupt,
+	.disable_interrupt = lapic_timer_disable_interrupt,
+	.register_interrupt = lapic_timer_register_interrupt
+};
+/* accessed from 'arch' layer via: extern arch_timer_t lapic_timer */
+
+extern arch_timer_t i8253; /* used for calibration */
+
+static volatile uint32 *lapic;	/* local APIC registers */
+static int deadline_mode;	/* TSC-deadline mode is used */
+static uint32 lt_freq;		/* counter frequency (kHz) */
+static uint32 nsec_per_count;	/* conversion factors (see lapic_timer.h) */
+static uint32 count_per_nsec;
+static uint32 lvt_mode;		/* timer mode (LVT) */
+static uint64 deadline;		/* last deadline (TSC-deadline mode) */
+
+static inline uint32 lapic_read ( uint32 reg )
+{
+	return lapic[reg >> 2];
+}
+
+static inline void lapic_write ( uint32 reg, uint32 value )
+{
+	lapic[reg >> 2] = value;
+}
+
+static inline uint64 rdtsc ()
+{
+	uint32 lo, hi;
+
+	asm volatile ( "rdtsc" : "=a" (lo), "=d" (hi) );
+
+	return ( ( (uint64) hi ) << 32 ) | lo;
+}
+
+/*! Enable local APIC, measure counter frequency, calculate intervals */
+static void lapic_timer_init ()
+{
+	uint32 eax, ebx, ecx, edx;
+	ktime_t max_count;
+
+	asm volatile ( "cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+			       : "a" (1) );
+	if ( !( edx & CPUID_APIC ) )
+	{
+		LOG ( ERROR, "Local APIC not present!\n" );
+		halt ();
+	}
+	deadline_mode = ( ecx & CPUID_DEADLINE ) != 0;
+
+	asm volatile ( "rdmsr" : "=a" (eax), "=d" (edx) : "c" (MSR_APIC_BASE) );
+	lapic = (void *) ( eax & 0xfffff000 );
+
+	/* software enable (also done in smp.c, which is initialized later) */
+	lapic_write ( LAPIC_SVR, LAPIC_SVR_ENABLE | INT_SPURIOUS );
+
+	lapic_write ( LAPIC_LVT_TIMER, LAPIC_LVT_MASKED );
+	lapic_write ( LAPIC_TIMER_DIVIDE, LAPIC_DIVIDE_16 );
+
+	lapic_timer_calibrate ();
+
+	if ( deadline_mode )
+		lvt_mode = LAPIC_TIMER_DEADLINE;
+	else
+		lvt_mode = LAPIC_TIMER_PERIODIC;
+
+	lapic_write ( LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | lvt_mode |
+				       INT_LAPIC_TIMER );
+
+	nsec_per_count = mul_div_32 ( N1E6, 1 << LT_SHIFT, lt_freq );
+	count_per_nsec = mul_div_32 ( lt_freq, 1 << LT_SHIFT, N1E6 );
+
+	/* shorter intervals would only cause interrupt storms */
+	lapic_timer.min_interval = LT_MIN_INTERVAL;
+
+	lapic_timer.max_interval = LT_MAX_INTERVAL;
+	COUNT_TO_TIME ( 0xffffffff, max_count );
+	if ( max_count < lapic_timer.max_interval )
+		lapic_timer.max_interval = max_count;
+
+	lapic_timer_set_time_to_counter ( lapic_timer.max_interval );
+}
+
+/*!
+ * Measure frequency of time stamp counter (TSC-deadline mode) or APIC timer
+ * counter with i8253 (its interrupts are not enabled)
+ */
+static void lapic_timer_calibrate ()
+{
+	ktime_t prev, cur, elapsed;
+	uint64 tsc;
+	uint32 ticks;
+
+	i8253.init ();
+
+	elapsed = 0;
+	prev = i8253.get_interval_remainder ();
+
+	tsc = rdtsc ();
+	lapic_write ( LAPIC_TIMER_INIT, 0xffffffff );
+
+	while ( elapsed < LT_CALIBRATE )
+	{
+		cur = i8253.get_interval_remainder ();
+
+		if ( cur > prev )
+			elapsed += i8253.max_interval; /* restarted */
+		elapsed += prev - cur;
+
+		prev = cur;
+	}
+
+	if ( deadline_mode )
+		ticks = (uint32) ( rdtsc () - tsc );
+	else
+		ticks = 0xffffffff - lapic_read ( LAPIC_TIMER_CURRENT );
+
+	lapic_write ( LAPIC_TIMER_INIT, 0 );
+
+	lt_freq = mul_div_32 ( ticks, N1E6, (uint32) elapsed );
+}
+
+/*! Start counting 'cnt' ticks */
+static void lapic_timer_set ( uint32 cnt )
+{
+	if ( deadline_mode )
+	{
+		deadline = rdtsc () + cnt;
+		asm volatile ( "wrmsr" :: "c" (MSR_TSC_DEADLINE),
+			       "a" ( (uint32) deadline ),
+			       "d" ( (uint32) ( deadline >> 32 ) ) );
+	}
+	else {
+		lapic_write ( LAPIC_TIMER_INIT, cnt );
+	}
+}
+
+/*! Get number of ticks until timer expires */
+static uint32 lapic_timer_get ()
+{
+	uint64 now;
+
+	if ( deadline_mode )
+	{
+		now = rdtsc ();
+		return now < deadline ? (uint32) ( deadline - now ) : 0;
+	}
+	else {
+		return lapic_read ( LAPIC_TIMER_CURRENT );
+	}
+}
+
+/*! Load counter with number equivalent to 'time' */
+static void lapic_timer_set_time_to_counter ( ktime_t time )
+{
+	uint32 cnt;
+
+	ASSERT ( time <= lapic_timer.max_interval &&
+		 time >= lapic_timer.min_interval );
+
+	TIME_TO_COUNT ( time, cnt );
+
+	lapic_timer_set ( cnt );
+}
+
+/*! Read current value from counter and convert it into time */
+static ktime_t lapic_timer_get_time_from_counter ()
+{
+	uint32 cnt;
+	ktime_t time;
+
+	cnt = lapic_timer_get ();
+
+	COUNT_TO_TIME ( cnt, time );
+
+	return time;
+}
+
+/*! Enable counter interrupts */
+static void lapic_timer_enable_interrupt ()
+{
+	lapic_write ( LAPIC_LVT_TIMER, lvt_mode | INT_LAPIC_TIMER );
+}
+
+/*! Disable counter interrupts */
+static void lapic_timer_disable_interrupt ()
+{
+	lapic_write ( LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | lvt_mode |
+				       INT_LAPIC_TIMER );
+}
+
+/*! Register function for counter interrupts (after acknowledging them) */
+static void lapic_timer_register_interrupt ( void *handler )
+{
+	arch_register_interrupt_handler ( INT_LAPIC_TIMER, lapic_timer_eoi,
+					  &lapic_timer );
+	arch_register_interrupt_handler ( INT_LAPIC_TIMER, handler,
+					  &lapic_timer );
+}
+
+/*! Acknowledge interrupt to local APIC */
+static int lapic_timer_eoi ( unsigned int inum, void *device )
+{
+	lapic_write ( LAPIC_EOI, 0 );
+
+	return 0;
+}
+
+#endif /* LAPIC_TIMER */
@@ -0,0 +1,62 @@
+/*! Local APIC timer (timer device) - included from only lapic_timer.c ! */
+#ifdef LAPIC_TIMER
+
+#pragma once
+
+#include <arch/time.h>
+#include <kernel/time.h>
+#include <lib/bits.h>
+#include <lib/types.h>
+
+#define N1E6		1000000L
+
+#define LT_MIN_INTERVAL	10000		/* 10 us */
+/* interval is limited so that counter values fit in 32 bits (up to 8 GHz) */
+#define LT_MAX_INTERVAL	500000000	/* 0.5 s */
+#define LT_CALIBRATE	20000000	/* measure frequency for 20 ms */
+
+/* fixed point factors (calculated from frequency) are scaled by 2^LT_SHIFT */
+#define LT_SHIFT	24
+
+/* Calculate time (nanoseconds) from counter value */
+#define COUNT_TO_TIME(C, T)	\
+do { T = ( (uint64) (C) * nsec_per_count ) >> LT_SHIFT; } while(0)
+
+/* Calculate counter value from time (below LT_MAX_INTERVAL) */
+#define TIME_TO_COUNT(T, C) \
+do { C = ( (uint64) (uint32) (T) * count_per_nsec ) >> LT_SHIFT; } while(0)
+
+/* local APIC registers (offsets from its base address) */
+#define LAPIC_EOI		0x0B0
+#define LAPIC_SVR		0x0F0
+#define LAPIC_LVT_TIMER		0x320
+#define LAPIC_TIMER_INIT	0x380
+#define LAPIC_TIMER_CURRENT	0x390
+#define LAPIC_TIMER_DIVIDE	0x3E0
+
+#define LAPIC_SVR_ENABLE	0x00000100
+
+#define LAPIC_LVT_MASKED	0x00010000
+#define LAPIC_TIMER_PERIODIC	0x00020000
+#define LAPIC_TIMER_DEADLINE	0x00040000
+#define LAPIC_DIVIDE_16		0x3
+
+#define MSR_APIC_BASE		0x1B
+#define MSR_TSC_DEADLINE	0x6E0
+#define CPUID_APIC		( 1 << 9 )  /* local APIC present (cpuid 1, edx) */
+#define CPUID_DEADLINE		( 1 << 24 ) /* TSC-deadline mode (cpuid 1, ecx) */
+
+static void lapic_timer_init ();
+static void lapic_timer_set ( uint32 cnt );
+static uint32 lapic_timer_get ();
+static void lapic_timer_calibrate ();
+static void lapic_timer_enable_interrupt ();
+static void lapic_timer_disable_interrupt ();
+
+static void lapic_timer_register_interrupt ( void *handler );
+static int lapic_timer_eoi ( unsigned int inum, void *device );
+
+static void lapic_timer_set_time_to_counter ( ktime_t time );
+static ktime_t lapic_timer_get_time_from_counter ();
+
+#endif /* LAPIC_TIMER */
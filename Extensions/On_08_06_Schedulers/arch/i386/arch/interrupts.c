@@ -5,6 +5,8 @@
 
 #include <arch/io.h>
 #include <arch/processor.h>
+#include <arch/context.h>
+#include <arch/smp.h>
 #include <kernel/errno.h>
 #include <lib/list.h>
 #include <kernel/memory.h>
@@ -19,13 +21,6 @@ void (*arch_irq_disable) ( unsigned int );
 /*! interrupt handlers */
 static list_t ihandlers[INTERRUPTS];
 
-/*!
- * interrupted: user program or kernel
- * (for tracking processor generated interrupts)
- */
-static int new_mode = KERNEL_MODE;
-static int prev_mode = KERNEL_MODE;
-
 struct ihndlr
 {
 	void *device;
@@ -97,10 +92,14 @@ void arch_unregister_interrupt_handler ( unsigned int irq_num, void *handler,
  */
 void arch_interrupt_handler ( int irq_num )
 {
+	arch_cpu_t *cpu = &arch_cpus[arch_cpu_id ()];
 	struct ihndlr *ih;
 
-	prev_mode = new_mode;
-	new_mode = KERNEL_MODE;
+	/* only one processor at a time in kernel */
+	arch_kernel_lock ();
+
+	cpu->prev_mode = cpu->new_mode;
+	cpu->new_mode = KERNEL_MODE;
 
 	if ( irq_num < INTERRUPTS && (ih = list_get (&ihandlers[irq_num], FIRST)) )
 	{
@@ -127,16 +126,18 @@ void arch_interrupt_handler ( int irq_num )
 		halt ();
 	}
 
-	prev_mode = new_mode;
-	new_mode = USER_MODE;
+	cpu->prev_mode = cpu->new_mode;
+	cpu->new_mode = USER_MODE;
+
+	arch_kernel_unlock ();
 }
 
 int arch_new_mode ()
 {
-	return new_mode;
+	return arch_cpus[arch_cpu_id ()].new_mode;
 }
 
 int arch_prev_mode ()
 {
-	return prev_mode;
+	return arch_cpus[arch_cpu_id ()].prev_mode;
 }
\ No newline at end of file
@@ -43,4 +43,10 @@ int arch_prev_mode ();
 #define INT_GPF			13	/* General Protection Fault */
 
 #define SOFTWARE_INTERRUPT	SOFT_IRQ
-#define INTERRUPTS		NUM_IRQS
+
+/* local APIC interrupts (for multiprocessor support; see smp.c) */
+#define INT_RESCHEDULE		( SOFT_IRQ + 1 ) /* inter-processor interrupt */
+#define INT_LAPIC_TIMER		( SOFT_IRQ + 2 ) /* local APIC timer */
+#define INT_SPURIOUS		63 /* lowest 4 bits must be set on older CPUs */
+
+#define INTERRUPTS		( INT_SPURIOUS + 1 )
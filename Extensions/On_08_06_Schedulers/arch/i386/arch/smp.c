@@ -0,0 +1,245 @@
+/*! Multiprocessor support: starting other processors, kernel lock */
+
+#define _ARCH_SMP_C_
+#include "smp.h"
+
+#include <arch/context.h>
+#include <arch/interrupts.h>
+#include <arch/io.h>
+#include <lib/string.h>
+
+/*!
+ * Boot processor wakes up all other (application) processors with INIT and
+ * STARTUP inter-processor interrupts (through local APIC). Each of them
+ * starts in real mode in code copied to AP_START_ADR (smp.S), switches to
+ * protected mode, takes next free index and continues in 'arch_ap_startup'
+ * with its own stack, GDT and TSS. There it waits until kernel is initialized
+ * (function given with 'arch_smp_start').
+ * Only one processor at a time can execute kernel code (kernel lock is taken
+ * on every kernel entry, in 'arch_interrupt_handler').
+ */
+
+static volatile uint32 *lapic = NULL;	/* local APIC registers (NULL when
+					   there is no local APIC) */
+static int cpus = 1;			/* number of processors used */
+static int apic_ids[MAX_CPUS];		/* local APIC id for each processor */
+
+static volatile int cpus_ready = 0;	/* initialized application processors */
+static void (* volatile ap_start_func) () = NULL; /* where they continue */
+
+/*! kernel lock: 0 when free, otherwise index of processor holding it + 1 */
+static volatile int kernel_lock = 0;
+static int lock_depth[MAX_CPUS];	/* nesting depth, per processor */
+
+/*! next free processor index (taken by processor in smp.S) */
+volatile int arch_ap_next = 1;
+
+static inline uint32 lapic_read ( uint32 reg )
+{
+	return lapic[reg >> 2];
+}
+
+static inline void lapic_write ( uint32 reg, uint32 value )
+{
+	lapic[reg >> 2] = value;
+}
+
+/*! Detect local APIC and start other processors (if there are any) */
+void arch_smp_init ()
+{
+	extern char arch_ap_trampoline, arch_ap_trampoline_end;
+	uint32 eax, ebx, ecx, edx;
+	int i;
+
+	asm volatile ( "cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+			       : "a" (1) );
+	if ( !( edx & CPUID_APIC ) )
+		return; /* no local APIC - only boot processor is used */
+
+	asm volatile ( "rdmsr" : "=a" (eax), "=d" (edx) : "c" (MSR_APIC_BASE) );
+	lapic = (void *) ( eax & 0xfffff000 );
+
+	lapic_enable ( 0 );
+
+	arch_register_interrupt_handler ( INT_RESCHEDULE, lapic_eoi, NULL );
+	arch_register_interrupt_handler ( INT_SPURIOUS, lapic_spurious, NULL );
+
+	if ( MAX_CPUS < 2 )
+		return;
+
+	/* copy starting code where processors can execute it in real mode */
+	memcpy ( (void *) AP_START_ADR, &arch_ap_trampoline,
+		 &arch_ap_trampoline_end - &arch_ap_trampoline );
+
+	/* INIT, STARTUP, STARTUP to all processors except this one */
+	lapic_ipi ( 0, ICR_ALL_BUT_SELF | ICR_ASSERT | ICR_INIT );
+	delay ( 10000 );
+
+	for ( i = 0; i < 2; i++ )
+	{
+		lapic_ipi ( 0, ICR_ALL_BUT_SELF | ICR_ASSERT | ICR_STARTUP |
+			       ( AP_START_ADR >> 12 ) );
+		delay ( 200 );
+	}
+
+	/* wait (up to 100 ms) for processors to take their indexes */
+	for ( i = 0; i < 100 && arch_ap_next < MAX_CPUS; i++ )
+		delay ( 1000 );
+
+	/* processors which take index after this are stopped (smp.S) */
+	cpus = MAX_CPUS;
+	asm volatile ( "xchgl %0, %1" : "+r" (cpus), "+m" (arch_ap_next)
+				      :: "memory" );
+	if ( cpus > MAX_CPUS )
+		cpus = MAX_CPUS;
+
+	/* wait for started processors to complete their initialization */
+	while ( cpus_ready < cpus - 1 )
+		asm volatile ( "pause" );
+}
+
+/*!
+ * Let application processors continue with given function
+ * (called from boot processor when kernel is initialized)
+ */
+void arch_smp_start ( void (*func) () )
+{
+	ap_start_func = func;
+}
+
+/*! Number of processors used */
+int arch_cpu_count ()
+{
+	return cpus;
+}
+
+/*! Send reschedule interrupt (INT_RESCHEDULE) to processor 'cpu' */
+void arch_cpu_signal ( int cpu )
+{
+	if ( lapic && cpu < cpus && cpu != arch_cpu_id () )
+		lapic_ipi ( apic_ids[cpu], ICR_FIXED | ICR_ASSERT |
+			    INT_RESCHEDULE );
+}
+
+/*!
+ * Take kernel lock (on kernel entry)
+ * - if this processor already holds it (interrupt while in kernel, e.g.
+ *   fault in kernel code) continue without waiting; nesting is counted so
+ *   that lock is released only by outermost 'arch_kernel_unlock'
+ */
+void arch_kernel_lock ()
+{
+	int me = arch_cpu_id () + 1, old;
+
+	if ( kernel_lock == me )
+	{
+		lock_depth[me - 1]++;
+		return;
+	}
+
+	do {
+		while ( kernel_lock )
+			asm volatile ( "pause" );
+
+		old = 0;
+		asm volatile ( "lock cmpxchgl %2, %1"
+			       : "+a" (old), "+m" (kernel_lock)
+			       : "r" (me) : "memory" );
+	}
+	while ( old );
+
+	lock_depth[me - 1] = 1;
+}
+
+/*! Release kernel lock (on kernel exit) */
+void arch_kernel_unlock ()
+{
+	int me = arch_cpu_id ();
+
+	if ( --lock_depth[me] > 0 )
+		return;
+
+	asm volatile ( "" ::: "memory" );
+
+	kernel_lock = 0;
+}
+
+/*!
+ * Release kernel lock regardless of nesting depth (processor leaves kernel
+ * without returning through interrupt handlers, e.g. idle suspend)
+ */
+void arch_kernel_unlock_all ()
+{
+	lock_depth[arch_cpu_id ()] = 1;
+
+	arch_kernel_unlock ();
+}
+
+/*! Starting function for application processor (called from smp.S) */
+void arch_ap_startup ( int cpu )
+{
+	arch_cpu_init ( cpu ); /* GDT, TSS, IDT, interrupt stack */
+
+	lapic_enable ( cpu );
+
+	asm volatile ( "lock incl %0" : "+m" (cpus_ready) );
+
+	/* wait for boot processor to complete kernel initialization */
+	while ( !ap_start_func )
+		asm volatile ( "pause" );
+
+	ap_start_func ();
+}
+
+/*! Enable local APIC of this processor */
+static void lapic_enable ( int cpu )
+{
+	/* software enable; spurious interrupts to INT_SPURIOUS */
+	lapic_write ( LAPIC_SVR, LAPIC_SVR_ENABLE | INT_SPURIOUS );
+
+	if ( cpu == 0 )
+	{
+		/* boot processor receives i8259 interrupts (virtual wire) */
+		lapic_write ( LAPIC_LVT_LINT0, LAPIC_LVT_EXTINT );
+		lapic_write ( LAPIC_LVT_LINT1, LAPIC_LVT_NMI );
+	}
+	else {
+		lapic_write ( LAPIC_LVT_LINT0, LAPIC_LVT_MASKED );
+		lapic_write ( LAPIC_LVT_LINT1, LAPIC_LVT_MASKED );
+	}
+
+	lapic_write ( LAPIC_TPR, 0 ); /* accept all interrupts */
+
+	apic_ids[cpu] = lapic_read ( LAPIC_ID ) >> 24;
+}
+
+/*! Send inter-processor interrupt (destination is ignored for broadcast) */
+static void lapic_ipi ( int apic_id, uint32 icr )
+{
+	while ( lapic_read ( LAPIC_ICR_LO ) & ICR_PENDING )
+		asm volatile ( "pause" );
+
+	lapic_write ( LAPIC_ICR_HI, apic_id << 24 );
+	lapic_write ( LAPIC_ICR_LO, icr );
+}
+
+/*! Local APIC interrupt is handled (kernel handler is called after this) */
+static int lapic_eoi ( unsigned int inum, void *device )
+{
+	lapic_write ( LAPIC_EOI, 0 );
+
+	return 0;
+}
+
+/*! Spurious interrupt - ignore it (must not be acknowledged) */
+static int lapic_spurious ( unsigned int inum, void *device )
+{
+	return 0;
+}
+
+/*! Busy wait (about) 'usec' microseconds; writing to port 0x80 takes ~1 us */
+static void delay ( uint usec )
+{
+	while ( usec-- )
+		outb ( 0x80, 0 );
+}
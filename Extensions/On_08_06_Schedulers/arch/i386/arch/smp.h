@@ -0,0 +1,63 @@
+/*! Multiprocessor support: starting other processors, kernel lock */
+
+#pragma once
+
+/*! where starting code for application processors is copied (below 1 MB,
+    aligned to 4 KB; startup IPI carries AP_START_ADR >> 12) */
+#define AP_START_ADR	0x7000
+
+#ifndef ASM_FILE
+
+#include <lib/types.h>
+
+/*! interface for kernel */
+void arch_smp_init ();
+void arch_smp_start ( void (*func) () );
+int arch_cpu_count ();
+void arch_cpu_signal ( int cpu );
+
+void arch_kernel_lock ();
+void arch_kernel_unlock ();
+void arch_kernel_unlock_all ();
+
+#endif /* ASM_FILE */
+
+/*! rest of the file is only for 'arch/smp.c' ------------------------------- */
+
+#ifdef _ARCH_SMP_C_
+
+/*! local APIC registers (offsets from its base address) */
+#define LAPIC_ID		0x020
+#define LAPIC_TPR		0x080
+#define LAPIC_EOI		0x0B0
+#define LAPIC_SVR		0x0F0
+#define LAPIC_ICR_LO		0x300
+#define LAPIC_ICR_HI		0x310
+#define LAPIC_LVT_LINT0		0x350
+#define LAPIC_LVT_LINT1		0x360
+
+#define LAPIC_SVR_ENABLE	0x00000100
+
+#define LAPIC_LVT_MASKED	0x00010000
+#define LAPIC_LVT_EXTINT	0x00000700
+#define LAPIC_LVT_NMI		0x00000400
+
+#define ICR_FIXED		0x00000000
+#define ICR_INIT		0x00000500
+#define ICR_STARTUP		0x00000600
+#define ICR_PENDING		0x00001000
+#define ICR_ASSERT		0x00004000
+#define ICR_ALL_BUT_SELF	0x000C0000
+
+#define MSR_APIC_BASE		0x1B	/* model specific register */
+#define CPUID_APIC		( 1 << 9 ) /* local APIC present (cpuid 1, edx) */
+
+static void lapic_enable ( int cpu );
+static void lapic_ipi ( int apic_id, uint32 icr );
+static int lapic_eoi ( unsigned int inum, void *device );
+static int lapic_spurious ( unsigned int inum, void *device );
+static void delay ( uint usec );
+
+void arch_ap_startup ( int cpu );
+
+#endif /* _ARCH_SMP_C_ */
@@ -3,87 +3,261 @@
 #include "time.h"
 
 #include <lib/types.h>
+#include <lib/bits.h>
 
 extern arch_timer_t TIMER;
 static arch_timer_t *timer = &TIMER;
 
-static time_t clock;	/* system time starting from 0:00 at power on */
-static time_t delay;	/* delay set by kernel, or timer->max_count */
-static time_t last_load;/* last time equivalent loaded to counter */
+static ktime_t clock;	/* system time starting from 0:00 at power on */
+static ktime_t last_load;/* last time equivalent loaded to counter */
 
-static time_t threshold;/* timer->min_interval / 2 */
+/*
+ * Time stamp counter as clocksource: when present, its frequency is measured
+ * with timer device at boot and time is then calculated from it, without
+ * reading timer device (which is used only as interrupt source); conversion
+ * uses 'tsc_mult' (nanoseconds per TSC tick, scaled by 2^TSC_SHIFT) and
+ * 'tsc_base' which is moved forward each second, so differences stay small.
+ * TSC is assumed to be constant rate and synchronized between processors.
+ */
+#define TSC_SHIFT		24
+#define TSC_CALIBRATE_NSEC	50000000	/* measure for 50 ms */
+#define CPUID_TSC		( 1 << 4 ) /* TSC present (cpuid 1, edx) */
+
+static uint32 tsc_mult;		/* zero if TSC isn't used */
+static uint64 tsc_base;		/* TSC value at 'tsc_base_time' */
+static ktime_t tsc_base_time;
+
+static inline uint64 arch_rdtsc ()
+{
+	uint32 lo, hi;
+
+	asm volatile ( "rdtsc" : "=a" (lo), "=d" (hi) );
 
+	return ( ( (uint64) hi ) << 32 ) | lo;
+}
+
+static void arch_tsc_calibrate ();
+static ktime_t arch_tsc_get_time ();
+
+static ktime_t threshold;/* timer->min_interval / 2 */
+
+/*
+ * Three independent one-shot timers share the same counter: one for kernel
+ * alarms, one for the scheduler (time slices) and one for frame boundaries
+ * of time-triggered (cyclic) schedule; counter is always loaded with the
+ * interval to the nearest one (or timer->max_interval)
+ */
+static ktime_t alarm_time;	/* when to call 'alarm_handler' (absolute) */
 static void (*alarm_handler) (); /* kernel function - call when alarm given by
-				    kernel ('delay') expires */
+				    kernel expires */
+
+static ktime_t sched_time;	/* when to call 'sched_handler' (absolute) */
+static void (*sched_handler) (); /* kernel function - call when scheduler
+				    timer expires */
+
+static ktime_t frame_time;	/* when to call 'frame_handler' (absolute) */
+static void (*frame_handler) (); /* kernel function - call on frame boundary */
 
 static void arch_timer_handler (); /* whenever timer expires call this */
+static void arch_timer_update ();
+static void arch_timer_load ();
 
 void arch_enable_timer_interrupt ()	{ timer->enable_interrupt ();	}
 void arch_disable_timer_interrupt ()	{ timer->disable_interrupt ();	}
 
-void arch_get_min_interval ( time_t *time ) { *time = timer->min_interval; }
+ktime_t arch_get_min_interval () { return timer->min_interval; }
 
 /*! Initialize timer 'arch' subsystem: timer device, subsystem data */
 void arch_timer_init ()
 {
-	clock.sec = clock.nsec = 0;
+	clock = 0;
+
+	alarm_handler = sched_handler = frame_handler = NULL;
 
 	timer->init ();
 
-	last_load = delay = timer->max_interval;
+	last_load = timer->max_interval;
 
-	timer->set_interval ( &last_load );
+	timer->set_interval ( last_load );
 	timer->register_interrupt ( arch_timer_handler );
 	timer->enable_interrupt ();
 
-	threshold.sec = timer->min_interval.sec / 2;
-	threshold.nsec = timer->min_interval.nsec / 2;
-	if ( timer->min_interval.sec % 2 )
-		threshold.nsec += 1000000000L / 2; /* + half second */
+	threshold = timer->min_interval / 2;
+
+	arch_tsc_calibrate ();
 
 	return;
 }
 
+/*! Measure TSC frequency with timer device (if processor has TSC) */
+static void arch_tsc_calibrate ()
+{
+	uint32 eax, ebx, ecx, edx;
+	ktime_t prev, cur, elapsed;
+	uint64 start, ticks;
+
+	tsc_mult = 0;
+
+	asm volatile ( "cpuid" : "=a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx)
+			       : "a" (1) );
+	if ( !( edx & CPUID_TSC ) )
+		return;
+
+	/* count time on timer device (it restarts counting when it expires) */
+	elapsed = 0;
+	prev = timer->get_interval_remainder ();
+	start = arch_rdtsc ();
+
+	while ( elapsed < TSC_CALIBRATE_NSEC )
+	{
+		cur = timer->get_interval_remainder ();
+
+		if ( cur > prev )
+			elapsed += last_load; /* restarted */
+		elapsed += prev - cur;
+
+		prev = cur;
+	}
+
+	ticks = arch_rdtsc () - start;
+
+	/* ignore TSC slower than 2^(32-TSC_SHIFT) ticks per nanosecond */
+	if ( ( ticks >> 32 ) || ( (uint32) ticks ) <
+	     ( (uint32) elapsed >> ( 32 - TSC_SHIFT ) ) )
+		return;
+
+	/* continue from current time */
+	tsc_base_time = arch_get_ktime ();
+	tsc_base = arch_rdtsc ();
+	tsc_mult = mul_div_32 ( (uint32) elapsed, 1 << TSC_SHIFT,
+				(uint32) ticks );
+}
+
+/*! Calculate current time from TSC */
+static ktime_t arch_tsc_get_time ()
+{
+	uint64 tsc, ticks;
+	ktime_t time;
+
+	tsc = arch_rdtsc ();
+	ticks = tsc - tsc_base;
+
+	time = tsc_base_time +
+	       ( ( ( ticks & 0xffffffff ) * tsc_mult ) >> TSC_SHIFT ) +
+	       ( ( ( ticks >> 32 ) * tsc_mult ) << ( 32 - TSC_SHIFT ) );
+
+	/* move base forward (sub-nanosecond part is lost) */
+	if ( time - tsc_base_time > KTIME_SEC )
+	{
+		tsc_base = tsc;
+		tsc_base_time = time;
+	}
+
+	return time;
+}
+
 /*!
- * Set next timer activation
- * \param time Time of next activation
+ * Set next timer activation (for kernel alarms)
+ * \param time Time of next activation (absolute)
  * \param alarm_func Function to call upon timer expiration
  */
-void arch_timer_set ( time_t *time, void *alarm_func )
+void arch_timer_set ( ktime_t time, void *alarm_func )
 {
-	time_t remainder;
+	arch_timer_update ();
 
-	timer->get_interval_remainder ( &remainder );
-	time_sub ( &last_load, &remainder );
-	time_add ( &clock, &last_load );
+	alarm_time = time;
+	alarm_handler = alarm_func;
 
-	delay = *time;
-	if ( time_cmp ( &delay, &timer->min_interval ) < 0 )
-		delay = timer->min_interval;
+	arch_timer_load ();
+}
 
-	alarm_handler = alarm_func;
+/*!
+ * Set (or cancel) scheduler timer activation; it is independent of kernel
+ * alarms, so setting it doesn't require going through alarm list
+ * \param time Time of next activation (absolute)
+ * \param sched_func Function to call upon timer expiration (NULL to cancel)
+ */
+void arch_sched_timer_set ( ktime_t time, void *sched_func )
+{
+	arch_timer_update ();
 
-	if ( time_cmp ( &delay, &timer->max_interval ) > 0 )
-		last_load = timer->max_interval;
-	else
-		last_load = delay;
+	sched_time = time;
+	sched_handler = sched_func;
+
+	arch_timer_load ();
+}
+
+/*!
+ * Set (or cancel) frame timer activation; like scheduler timer, but reserved
+ * for frame boundaries, so time slices can't delay them
+ * \param time Time of next activation (absolute)
+ * \param frame_func Function to call upon timer expiration (NULL to cancel)
+ */
+void arch_frame_timer_set ( ktime_t time, void *frame_func )
+{
+	arch_timer_update ();
 
-	timer->set_interval ( &last_load );
+	frame_time = time;
+	frame_handler = frame_func;
+
+	arch_timer_load ();
 }
 
 /*!
  * Get 'current' system time
+ * \return current time
+ */
+ktime_t arch_get_ktime ()
+{
+	if ( tsc_mult )
+		return arch_tsc_get_time ();
+
+	return clock + last_load - timer->get_interval_remainder ();
+}
+
+/*!
+ * Get 'current' system time (as time_t)
  * \param time Store address for current time
  */
 void arch_get_time ( time_t *time )
 {
-	time_t remainder;
+	ktime_to_time ( arch_get_ktime (), time );
+}
+
+/*! Add time elapsed from last counter load to 'clock' */
+static void arch_timer_update ()
+{
+	if ( tsc_mult )
+	{
+		clock = arch_tsc_get_time ();
+		return;
+	}
+
+	last_load -= timer->get_interval_remainder ();
+	clock += last_load;
+}
+
+/*! Load counter with interval to nearest timer activation (from 'clock') */
+static void arch_timer_load ()
+{
+	ktime_t next = timer->max_interval;
+
+	if ( alarm_handler && alarm_time - clock < next )
+		next = alarm_time - clock;
+
+	if ( sched_handler && sched_time - clock < next )
+		next = sched_time - clock;
+
+	if ( frame_handler && frame_time - clock < next )
+		next = frame_time - clock;
+
+	/* (also when activation time already passed) */
+	if ( next < timer->min_interval )
+		next = timer->min_interval;
 
-	timer->get_interval_remainder ( &remainder );
+	last_load = next;
 
-	*time = last_load;
-	time_sub ( time, &remainder );
-	time_add ( time, &clock );
+	timer->set_interval ( last_load );
 }
 
 /*!
@@ -92,28 +266,45 @@ void arch_get_time ( time_t *time )
  */
 static void arch_timer_handler ()
 {
-	void (*k_handler) ();
+	void (*k_alarm) () = NULL, (*k_sched) () = NULL, (*k_frame) () = NULL;
+	ktime_t ref_time;
 
-	time_add ( &clock, &last_load );
+	if ( tsc_mult )
+		clock = arch_tsc_get_time ();
+	else
+		clock += last_load;
 
-	time_sub ( &delay, &last_load );
-	last_load = timer->max_interval;
+	ref_time = clock + threshold;
 
-	if ( time_cmp ( &delay, &threshold ) <= 0 )
+	if ( alarm_handler && alarm_time <= ref_time )
 	{
-		delay = timer->max_interval;
-		timer->set_interval ( &last_load );
-
-		k_handler = alarm_handler;
+		k_alarm = alarm_handler;
 		alarm_handler = NULL; /* reset kernel callback function */
+	}
 
-		if ( k_handler )
-			k_handler (); /* forward interrupt to kernel */
+	if ( sched_handler && sched_time <= ref_time )
+	{
+		k_sched = sched_handler;
+		sched_handler = NULL;
 	}
-	else {
-		if ( time_cmp ( &delay, &last_load ) < 0 )
-			last_load = delay;
 
-		timer->set_interval ( &last_load );
+	if ( frame_handler && frame_time <= ref_time )
+	{
+		k_frame = frame_handler;
+		frame_handler = NULL;
 	}
+
+	arch_timer_load ();
+
+	/* forward interrupt to kernel; frame boundary first (it must not be
+	   delayed), then scheduler, since kernel alarms handler always checks
+	   alarm list for expired alarms */
+	if ( k_frame )
+		k_frame ();
+
+	if ( k_sched )
+		k_sched ();
+
+	if ( k_alarm )
+		k_alarm ();
 }
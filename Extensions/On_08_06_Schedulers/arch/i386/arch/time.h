@@ -3,16 +3,17 @@
 #pragma once
 
 #include <lib/types.h>
+#include <lib/ktime.h>
 
 /*! (arch) timer interface */
 typedef struct _arch_timer_t_
 {
-	time_t min_interval;
-	time_t max_interval;
+	ktime_t min_interval;
+	ktime_t max_interval;
 
 	void (*init) ();
-	void (*set_interval) ( time_t * );
-	void (*get_interval_remainder) ( time_t * );
+	void (*set_interval) ( ktime_t );
+	ktime_t (*get_interval_remainder) ();
 	void (*enable_interrupt) ();
 	void (*disable_interrupt) ();
 	void (*register_interrupt) ( void *handler );
@@ -21,9 +22,12 @@ arch_timer_t;
 
 /*! interface for kernel  */
 void arch_timer_init ();
-void arch_timer_set ( time_t *time, void *alarm_func );
+void arch_timer_set ( ktime_t time, void *alarm_func );
+void arch_sched_timer_set ( ktime_t time, void *sched_func );
+void arch_frame_timer_set ( ktime_t time, void *frame_func );
 void arch_get_time ( time_t *time );
-void arch_get_min_interval ( time_t *time );
+ktime_t arch_get_ktime ();
+ktime_t arch_get_min_interval ();
 
 void arch_enable_timer_interrupt ();
 void arch_disable_timer_interrupt ();
@@ -0,0 +1,247 @@
+/*! Admission control for real-time threads */
+#define _KERNEL_
+
+/*!
+ * Real-time threads with known worst case execution time (WCET), EDF threads
+ * and periodic threads, are admitted only if whole set stays schedulable on
+ * single processor:
+ * 1. total density, sum of C / min(D,T), must not exceed 1 (for EDF this is
+ *    exact when deadlines equal periods, sufficient otherwise)
+ * 2. each periodic (fixed priority) thread must meet its deadline by response
+ *    time analysis: R = C + sum of ceil(R/Tj) * Cj for interfering threads -
+ *    periodic threads with same or higher priority and all EDF threads (their
+ *    priorities change, so they are assumed higher)
+ * Threads with unknown (zero) WCET are not included. Priority of periodic
+ * thread is taken when it is admitted.
+ * Unless compiled with ADMISSION_WARN, thread which would make set not
+ * schedulable is rejected; otherwise only warning is printed.
+ * Times are given as ktime_t and analysed in microseconds, so 32 bit
+ * arithmetic suffices (no 64 bit division in kernel).
+ */
+
+#define _K_ADMISSION_C_
+#include "admission.h"
+
+#include <kernel/kprint.h>
+#include <kernel/errno.h>
+#include <lib/bits.h>
+#include <lib/types.h>
+
+/*! Admitted threads */
+static kadmit_t admitted[MAX_THREADS];
+
+/*!
+ * Test if set of admitted threads stays schedulable if 'kthread' is added
+ * with given parameters (or its parameters are changed)
+ * \param kthread Thread (may be NULL when thread is not yet created)
+ * \param type ADMIT_EDF or ADMIT_FP
+ * \param prio Thread priority (for ADMIT_FP)
+ * \param period Period
+ * \param deadline Relative deadline (zero: same as period)
+ * \param wcet Worst case execution time (if zero, test is not performed)
+ * \return SUCCESS or E_NOT_SCHEDULABLE
+ */
+int k_admit_test ( void *kthread, int type, int prio, ktime_t period,
+		   ktime_t deadline, ktime_t wcet )
+{
+	kadmit_t *entry, old;
+	int schedulable;
+
+	if ( wcet <= 0 )
+		return SUCCESS;
+
+	/* tested thread temporarily replaces its entry (or takes empty one) */
+	entry = NULL;
+	if ( kthread )
+		entry = k_admit_find ( kthread );
+	if ( !entry )
+		entry = k_admit_find ( NULL );
+	if ( !entry )
+		return E_NOT_SCHEDULABLE; /* table is full */
+
+	old = *entry;
+	k_admit_set ( entry, kthread ? kthread : (void *) entry, type, prio,
+		      period, deadline, wcet );
+
+	schedulable = k_admit_schedulable ();
+
+	*entry = old;
+
+	if ( schedulable )
+		return SUCCESS;
+
+#ifdef	ADMISSION_WARN
+	kprint ( "Admission: real-time threads are not schedulable "
+		 "(admitted anyway)\n" );
+	return SUCCESS;
+#else
+	return E_NOT_SCHEDULABLE;
+#endif
+}
+
+/*!
+ * Add thread to admitted set (or change its parameters), without testing;
+ * thread with zero WCET is removed from set
+ */
+void k_admit_add ( void *kthread, int type, int prio, ktime_t period,
+		   ktime_t deadline, ktime_t wcet )
+{
+	kadmit_t *entry;
+
+	ASSERT ( kthread );
+
+	if ( wcet <= 0 )
+	{
+		k_admit_remove ( kthread );
+		return;
+	}
+
+	entry = k_admit_find ( kthread );
+	if ( !entry )
+		entry = k_admit_find ( NULL );
+	ASSERT ( entry );
+
+	k_admit_set ( entry, kthread, type, prio, period, deadline, wcet );
+}
+
+/*! Remove thread from admitted set (if it is there) */
+void k_admit_remove ( void *kthread )
+{
+	kadmit_t *entry;
+
+	if ( kthread && ( entry = k_admit_find ( kthread ) ) )
+		entry->kthread = NULL;
+}
+
+/*! Find entry for thread (or unused entry, for NULL) */
+static kadmit_t *k_admit_find ( void *kthread )
+{
+	int i;
+
+	for ( i = 0; i < MAX_THREADS; i++ )
+		if ( admitted[i].kthread == kthread )
+			return &admitted[i];
+
+	return NULL;
+}
+
+/*! Fill entry (deadline is limited by period) */
+static void k_admit_set ( kadmit_t *entry, void *kthread, int type, int prio,
+			  ktime_t period, ktime_t deadline, ktime_t wcet )
+{
+	entry->kthread = kthread;
+	entry->type = type;
+	entry->prio = prio;
+	entry->period = k_admit_us ( period, FALSE );
+	entry->deadline = entry->period;
+	if ( deadline > 0 )
+		entry->deadline = k_admit_us ( deadline, FALSE );
+	if ( entry->deadline > entry->period )
+		entry->deadline = entry->period;
+	entry->wcet = k_admit_us ( wcet, TRUE );
+}
+
+/*! Run both tests on admitted set */
+static int k_admit_schedulable ()
+{
+	uint density = 0;
+	int i;
+
+	for ( i = 0; i < MAX_THREADS; i++ )
+	{
+		if ( !admitted[i].kthread )
+			continue;
+
+		if ( admitted[i].wcet > admitted[i].deadline )
+			return FALSE;
+
+		density += k_admit_density ( admitted[i].wcet,
+					     admitted[i].deadline );
+		if ( density > ADMIT_ONE )
+			return FALSE;
+	}
+
+	for ( i = 0; i < MAX_THREADS; i++ )
+		if ( admitted[i].kthread && admitted[i].type == ADMIT_FP &&
+		     !k_admit_response_time ( &admitted[i] ) )
+			return FALSE;
+
+	return TRUE;
+}
+
+/*! Response time analysis for fixed priority thread: is R <= D? */
+static int k_admit_response_time ( kadmit_t *task )
+{
+	kadmit_t *other;
+	uint r, next;
+	int i;
+
+	next = task->wcet;
+
+	do {
+		r = next;
+		next = task->wcet;
+
+		for ( i = 0; i < MAX_THREADS; i++ )
+		{
+			other = &admitted[i];
+
+			if ( !other->kthread || other == task ||
+			     ( other->type == ADMIT_FP &&
+			       other->prio < task->prio ) )
+				continue;
+
+			/* r, period < 2^30 and wcet <= period: no overflow */
+			next += ( ( r + other->period - 1 ) / other->period ) *
+				other->wcet;
+
+			if ( next > task->deadline )
+				return FALSE;
+		}
+	}
+	while ( next != r );
+
+	return TRUE;
+}
+
+/*! Convert time to microseconds (limited to ADMIT_MAX_US) */
+static uint k_admit_us ( ktime_t t, int round_up )
+{
+	uint us, ns;
+
+	if ( t >= (ktime_t) ADMIT_MAX_US * 1000 )
+		return ADMIT_MAX_US;
+
+	us = div_64_32 ( t, 1000, &ns );
+	if ( round_up && ns )
+		us++;
+
+	if ( us == 0 )
+		us = 1;
+
+	return us;
+}
+
+/*! Calculate c / d as fraction of ADMIT_ONE, rounded up (c <= d) */
+static uint k_admit_density ( uint c, uint d )
+{
+	uint q = 0;
+	int i;
+
+	/* binary long division; c < d < 2^31, so 2 * c can't overflow */
+	if ( c >= d )
+		return ADMIT_ONE;
+
+	for ( i = 0; i < ADMIT_SHIFT; i++ )
+	{
+		c <<= 1;
+		q <<= 1;
+		if ( c >= d )
+		{
+			c -= d;
+			q |= 1;
+		}
+	}
+
+	return c ? q + 1 : q;
+}
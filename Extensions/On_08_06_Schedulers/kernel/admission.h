@@ -0,0 +1,53 @@
+/*! Admission control for real-time threads (schedulability test) */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/ktime.h>
+
+/*! Thread types (how they are scheduled) */
+#define ADMIT_EDF	1	/* EDF thread (dynamic priority) */
+#define ADMIT_FP	2	/* periodic thread with fixed priority */
+
+int k_admit_test ( void *kthread, int type, int prio, ktime_t period,
+		   ktime_t deadline, ktime_t wcet );
+void k_admit_add ( void *kthread, int type, int prio, ktime_t period,
+		   ktime_t deadline, ktime_t wcet );
+void k_admit_remove ( void *kthread );
+
+#endif /* _KERNEL_ */
+
+/*! rest of the file is only for 'kernel/admission.c' ----------------------- */
+
+#ifdef	_K_ADMISSION_C_
+
+/*! Admitted real-time thread (times in microseconds) */
+typedef struct _kadmit_t_
+{
+	void *kthread;		/* NULL for unused entry */
+	int type;		/* ADMIT_EDF or ADMIT_FP */
+	int prio;		/* priority (ADMIT_FP) */
+	uint period;
+	uint deadline;
+	uint wcet;
+}
+kadmit_t;
+
+/* times are limited so that 32 bit sums in analysis can't overflow */
+#define ADMIT_MAX_US	( 1 << 30 )
+
+/* utilization (density) is calculated as fraction of ADMIT_ONE */
+#define ADMIT_SHIFT	16
+#define ADMIT_ONE	( 1 << ADMIT_SHIFT )
+
+static kadmit_t *k_admit_find ( void *kthread );
+static void k_admit_set ( kadmit_t *entry, void *kthread, int type, int prio,
+			  ktime_t period, ktime_t deadline, ktime_t wcet );
+static int k_admit_schedulable ();
+static int k_admit_response_time ( kadmit_t *task );
+static uint k_admit_us ( ktime_t t, int round_up );
+static uint k_admit_density ( uint c, uint d );
+
+#endif	/* _K_ADMISSION_C_ */
@@ -60,7 +60,7 @@ int k_device_init ( kdevice_t *kdev, int flags, void *params, void *callback )
 		kdev->dev.params = params;
 
 	kdev->locked = FALSE;
-	kthreadq_init ( &kdev->thrq );
+	kthreadq_init_prio ( &kdev->thrq );
 
 	if ( kdev->dev.init )
 		retval = kdev->dev.init ( flags, params, &kdev->dev );
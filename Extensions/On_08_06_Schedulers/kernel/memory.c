@@ -213,11 +213,8 @@ int sys__sysinfo ( void *p )
 		}
 		else if ( strcmp ( "threads", param1 ) == 0 )
 		{
-			kthread_info ();
-			if ( strlen ( look_console ) > buf_size )
-				EXIT ( E_TOO_BIG );
-			strcpy ( buffer, look_console );
-			EXIT ( SUCCESS );
+			/* threads_info_t (not string) is returned */
+			EXIT ( kthread_info ( buffer, buf_size ) );
 			/* TODO: "thread thr_id" */
 		}
 		else {
@@ -35,6 +35,7 @@ extern MEM_ALLOC_T *k_mpool;
 /*! Kernel memory layout ---------------------------------------------------- */
 #include <lib/types.h>
 #include <lib/list.h>
+#include <lib/ktime.h>
 #include <api/prog_info.h>
 
 /* Memory segment */
@@ -75,8 +76,34 @@ typedef struct _kprocess_t_
 	prog_info_t *pi; /* process header (copy of program header) */
 	mseg_t m;
 
+	uint id;	/* process id (0 for kernel) */
+
 	int thr_count;
 
+	/* stride scheduler: tickets shared by process threads (if > 0) */
+	int stride_tickets;
+	int stride_thr_tickets;	/* sum of tickets of its stride threads */
+
+	/* real-time throttling: limit for process real-time threads */
+	ktime_t rt_runtime;	/* processor time per period (zero: no limit) */
+	ktime_t rt_used;	/* used in current period */
+	int rt_throttled;	/* limit reached in current period */
+
+	/* processor reservation: budget shared by all process threads */
+	ktime_t res_budget;	/* processor time per period (zero: no limit) */
+	ktime_t res_period;
+	int res_flags;		/* RESERVE_DEMOTE or 0 (see cpu_reserve_t) */
+	ktime_t res_used;	/* used in current period */
+	ktime_t res_period_end;	/* when current period ends */
+	int res_exhausted;	/* budget used up in current period */
+
+	void *alarm_dispatch;	/* alarm actions queue (see kernel/time.c) */
+
+	/* statistics: sum for all process threads (kthread_t) */
+	ktime_t run_time;
+	uint voluntary;
+	uint involuntary;
+
 	list_h all;
 }
 kprocess_t;
@@ -20,7 +20,7 @@ static list_t kmsg_qs = LIST_T_NULL;
 void k_thr_msg_init ( kthrmsg_qs *thrmsg )
 {
 	list_init ( &thrmsg->msgq.msgs );
-	kthreadq_init ( &thrmsg->msgq.thrq );
+	kthreadq_init_prio ( &thrmsg->msgq.thrq );
 	thrmsg->msgq.min_prio = 0;
 
 	thrmsg->sig_prio = 0;
@@ -72,7 +72,7 @@ int sys__create_msg_queue ( void *p )
 	ASSERT_ERRNO_AND_EXIT ( gmsgq, E_NO_MEMORY );
 
 	list_init ( &gmsgq->mq.msgs ); /* list for messages */
-	kthreadq_init ( &gmsgq->mq.thrq ); /* list for blocked threads */
+	kthreadq_init_prio ( &gmsgq->mq.thrq ); /* list for blocked threads */
 
 	gmsgq->mq.min_prio = min_prio;
 	msgq->id = gmsgq->id = k_new_unique_id ();
@@ -202,8 +202,9 @@ int sys__msg_post ( void *p )
 
 		new_kthr = kthread_create (
 			thrmsg->signal_handler,
-			K2U_GET_ADR ( cmsg, proc ), proc->pi->exit, 0,
-			kthread_get_prio ( kthr ) + 1, NULL, 0, 1, proc
+			K2U_GET_ADR ( cmsg, proc ), proc->pi->exit,
+			SCHED_SERVER, kthread_get_prio ( kthr ) + 1,
+			NULL, 0, 1, proc
 		);
 		ASSERT_ERRNO_AND_EXIT ( new_kthr, kthread_get_errno (NULL) );
 
@@ -298,6 +299,7 @@ int sys__msg_recv ( void *p )
 
 		SET_ERRNO ( E_RETRY );
 		/* block thread */
+		ksched_thread_ipc_block ( kthread_get_active () );
 		kthread_enqueue ( NULL, &kmsgq->thrq );
 
 		kthreads_schedule ();
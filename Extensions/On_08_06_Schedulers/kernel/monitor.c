@@ -10,6 +10,17 @@
 #include <kernel/errno.h>
 #include <lib/types.h>
 
+/*
+ * Priority inheritance: monitor owner runs with (at least) priority of highest
+ * priority thread blocked on any monitor it holds; if owner is itself blocked
+ * on another monitor, its (inherited) priority is passed to that monitor owner
+ * and so on, through the chain of monitors
+ */
+static void k_monitor_set_owner ( kmonitor_t *kmonitor, kthread_t *owner );
+static int k_monitor_inherit ( kthread_t *kthread );
+static void k_monitor_propagate ( kmonitor_t *kmonitor );
+static void k_monitor_enqueue ( kthread_t *kthread, kmonitor_t *kmonitor );
+
 /*! Initialize new monitor */
 int sys__monitor_init ( void *p )
 {
@@ -26,7 +37,7 @@ int sys__monitor_init ( void *p )
 
 	kmonitor->lock = FALSE;
 	kmonitor->owner = NULL;
-	kthreadq_init ( &kmonitor->queue );
+	kthreadq_init_prio ( &kmonitor->queue );
 
 	monitor->ptr = kmonitor;
 
@@ -46,8 +57,9 @@ int sys__monitor_destroy ( void *p )
 
 	kmonitor = monitor->ptr;
 
-	if ( kthreadq_release_all ( &kmonitor->queue ) )
-		kthreads_schedule ();
+	kthreadq_release_all ( &kmonitor->queue );
+	k_monitor_set_owner ( kmonitor, NULL );
+	kthreads_schedule ();
 
 	kfree ( kmonitor );
 	monitor->ptr = NULL;
@@ -69,7 +81,7 @@ int sys__monitor_queue_init ( void *p )
 	kqueue = kmalloc ( sizeof (kmonitor_q) );
 	ASSERT_ERRNO_AND_EXIT ( kqueue, E_NO_MEMORY );
 
-	kthreadq_init ( &kqueue->queue );
+	kthreadq_init_prio ( &kqueue->queue );
 
 	queue->ptr = kqueue;
 
@@ -116,10 +128,10 @@ int sys__monitor_lock ( void *p )
 	if ( !kmonitor->lock )
 	{
 		kmonitor->lock = TRUE;
-		kmonitor->owner = kthread_get_active ();
+		k_monitor_set_owner ( kmonitor, kthread_get_active () );
 	}
 	else {
-		kthread_enqueue ( NULL, &kmonitor->queue );
+		k_monitor_enqueue ( NULL, kmonitor );
 		kthreads_schedule ();
 	}
 
@@ -133,6 +145,7 @@ int sys__monitor_unlock ( void *p )
 	monitor_t *monitor;
 	/* local variables */
 	kmonitor_t *kmonitor;
+	kthread_t *owner;
 
 	monitor = U2K_GET_ADR ( *( (void **) p ), kthread_get_process (NULL) );
 	ASSERT_ERRNO_AND_EXIT ( monitor && monitor->ptr, E_INVALID_HANDLE );
@@ -144,11 +157,15 @@ int sys__monitor_unlock ( void *p )
 
 	SET_ERRNO ( SUCCESS );
 
-	kmonitor->owner = kthreadq_get ( &kmonitor->queue );
+	owner = kthreadq_get ( &kmonitor->queue );
 	if ( !kthreadq_release ( &kmonitor->queue ) )
 		kmonitor->lock = FALSE;
-	else
-		kthreads_schedule ();
+
+	/* new owner (if any) inherits from remaining blocked threads, while
+	   previous owner loses priority inherited through this monitor */
+	k_monitor_set_owner ( kmonitor, owner );
+
+	kthreads_schedule ();
 
 	RETURN ( SUCCESS );
 }
@@ -162,6 +179,7 @@ int sys__monitor_wait ( void *p )
 	/* local variables */
 	kmonitor_t *kmonitor;
 	kmonitor_q *kqueue;
+	kthread_t *owner;
 
 	monitor = U2K_GET_ADR ( *( (void **) p ), kthread_get_process (NULL) );
 	ASSERT_ERRNO_AND_EXIT ( monitor && monitor->ptr, E_INVALID_HANDLE );
@@ -182,10 +200,12 @@ int sys__monitor_wait ( void *p )
 	kthread_set_qdata ( NULL, kmonitor );
 	kthread_enqueue ( NULL, &kqueue->queue );
 
-	kmonitor->owner = kthreadq_get ( &kmonitor->queue );
+	owner = kthreadq_get ( &kmonitor->queue );
 	if ( !kthreadq_release ( &kmonitor->queue ) )
 		kmonitor->lock = FALSE;
 
+	k_monitor_set_owner ( kmonitor, owner );
+
 	kthreads_schedule ();
 
 	RETURN ( SUCCESS );
@@ -234,15 +254,16 @@ static int k_monitor_release ( void *p, int broadcast )
 		{
 			/* unblocked thread becomes monitor owner */
 			kmonitor->lock = TRUE;
-			kmonitor->owner = kthr;
 			kthreadq_release ( &kqueue->queue );/*to ready threads*/
+			k_monitor_set_owner ( kmonitor, kthr );
 			reschedule++;
 		}
 		else {
 			/* move thread from monitor queue (cond.var.)
 			   to monitor entrance queue */
 			kthr = kthreadq_remove ( &kqueue->queue, NULL );
-			kthread_enqueue ( kthr, &kmonitor->queue );
+			k_monitor_enqueue ( kthr, kmonitor );
+			reschedule++;
 		}
 	}
 	while ( kthr && broadcast );
@@ -254,3 +275,122 @@ static int k_monitor_release ( void *p, int broadcast )
 
 	RETURN ( SUCCESS );
 }
+
+/*! Priority inheritance ---------------------------------------------------- */
+
+/*!
+ * Change monitor owner: previous owner no longer inherits priority through
+ * this monitor, new owner does
+ */
+static void k_monitor_set_owner ( kmonitor_t *kmonitor, kthread_t *owner )
+{
+	kthread_t *prev = kmonitor->owner;
+
+	if ( prev )
+		list_remove ( kthread_get_locks ( prev ), FIRST,
+			      &kmonitor->locks );
+
+	kmonitor->owner = owner;
+
+	if ( owner )
+	{
+		list_append ( kthread_get_locks ( owner ), kmonitor,
+			      &kmonitor->locks );
+		k_monitor_propagate ( kmonitor );
+	}
+
+	if ( prev && prev != owner )
+		k_monitor_inherit ( prev );
+}
+
+/*!
+ * Recalculate priority thread inherits from threads blocked on monitors it
+ * holds
+ * \return TRUE if thread priority is changed
+ */
+static int k_monitor_inherit ( kthread_t *kthread )
+{
+	kmonitor_t *kmonitor;
+	kthread_t *kthr;
+	int prio = -1;
+
+	kmonitor = list_get ( kthread_get_locks ( kthread ), FIRST );
+	while ( kmonitor )
+	{
+		/* monitor queue is priority ordered */
+		kthr = kthreadq_get ( &kmonitor->queue );
+		if ( kthr && kthread_get_prio ( kthr ) > prio )
+			prio = kthread_get_prio ( kthr );
+
+		kmonitor = list_get_next ( &kmonitor->locks );
+	}
+
+	return kthread_set_inherited_prio ( kthread, prio );
+}
+
+/*!
+ * Recalculate priority of monitor owner; if changed and owner is blocked on
+ * another monitor, repeat for that monitor (transitive inheritance)
+ */
+static void k_monitor_propagate ( kmonitor_t *kmonitor )
+{
+	kthread_t *owner;
+
+	while ( kmonitor && kmonitor->owner &&
+		k_monitor_inherit ( kmonitor->owner ) )
+	{
+		owner = kmonitor->owner;
+
+		/* blocked threads keep monitor they wait for in 'qdata' */
+		kmonitor = kthread_get_qdata ( owner );
+		if ( !kmonitor ||
+		     kthread_get_queue ( owner ) != &kmonitor->queue )
+			break;
+	}
+}
+
+/*!
+ * Block thread on monitor (entrance queue) and pass its priority to monitor
+ * owner (and further)
+ * - 'kthreads_schedule' should follow this call
+ */
+static void k_monitor_enqueue ( kthread_t *kthread, kmonitor_t *kmonitor )
+{
+	kthread_set_qdata ( kthread, kmonitor );
+	kthread_enqueue ( kthread, &kmonitor->queue );
+
+	k_monitor_propagate ( kmonitor );
+}
+
+/*!
+ * Thread is canceled (and already removed from its queue 'queue'): pass each
+ * monitor it holds to first thread blocked on it (as on unlock) or leave it
+ * unlocked; if it was blocked on monitor, that monitor owner may lose
+ * priority inherited from it
+ * - 'kthreads_schedule' should follow this call
+ */
+void k_monitor_thread_cancel ( kthread_t *kthread, kthread_q *queue )
+{
+	kmonitor_t *kmonitor;
+	kthread_t *owner;
+
+	kmonitor = list_remove ( kthread_get_locks ( kthread ), FIRST, NULL );
+	while ( kmonitor )
+	{
+		/* canceled thread doesn't inherit anything any more */
+		kmonitor->owner = NULL;
+
+		owner = kthreadq_get ( &kmonitor->queue );
+		if ( !kthreadq_release ( &kmonitor->queue ) )
+			kmonitor->lock = FALSE;
+
+		k_monitor_set_owner ( kmonitor, owner );
+
+		kmonitor = list_remove ( kthread_get_locks ( kthread ), FIRST,
+					 NULL );
+	}
+
+	kmonitor = kthread_get_qdata ( kthread );
+	if ( queue && kmonitor && queue == &kmonitor->queue )
+		k_monitor_propagate ( kmonitor );
+}
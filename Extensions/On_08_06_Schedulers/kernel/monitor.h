@@ -13,6 +13,8 @@ typedef struct _kmonitor_t_
 	kthread_t *owner;	/* owner thread descriptor */
 
 	kthread_q queue;	/* queue for blocked threads */
+
+	list_h locks;		/* element of owner's list of locked monitors */
 }
 kmonitor_t;
 
@@ -34,3 +36,5 @@ int sys__monitor_wait ( void *p );
 int sys__monitor_signal ( void *p );
 int sys__monitor_broadcast ( void *p );
 
+void k_monitor_thread_cancel ( kthread_t *kthread, kthread_q *queue );
+
@@ -0,0 +1,306 @@
+/*! Periodic threads */
+#define _KERNEL_
+
+/*!
+ * Periodic thread is released every 'period'; each release starts new job
+ * which must complete (call wait_next_period) within 'deadline'. All periodic
+ * threads are kept in 'periodic_threads', those with completed job also wait
+ * in 'periodic_wait'. Single kernel alarm is armed for earliest release or
+ * deadline; on deadline miss, job is counted as overrun and thread's overrun
+ * handler (if set) is started as new thread.
+ */
+
+#define _K_PERIODIC_C_
+#include "periodic.h"
+
+#include <kernel/thread.h>
+#include <kernel/time.h>
+#include <kernel/memory.h>
+#include <kernel/admission.h>
+#include <kernel/errno.h>
+#include <lib/list.h>
+#include <lib/types.h>
+
+/* all periodic threads and those waiting for next release */
+static list_t periodic_threads;
+static kthread_q periodic_wait;
+static void *periodic_alarm;	/* for earliest release or deadline */
+static alarm_t periodic_alarm_params;
+
+/*! Initialize periodic threads list and alarm */
+void k_periodic_init ()
+{
+	list_init ( &periodic_threads );
+	kthreadq_init ( &periodic_wait );
+
+	periodic_alarm_params.exp_time.sec = 0;
+	periodic_alarm_params.exp_time.nsec = 0;
+	periodic_alarm_params.period.sec = periodic_alarm_params.period.nsec = 0;
+	periodic_alarm_params.action = k_periodic_timer;
+	periodic_alarm_params.param = NULL;
+	periodic_alarm_params.flags = 0;
+
+	k_alarm_new ( &periodic_alarm, &periodic_alarm_params, KERNELCALL );
+}
+
+/*! Thread is canceled: if periodic, remove it from list and admitted ones */
+void k_periodic_remove ( void *kthread )
+{
+	kperiodic_t *kperiodic = kthread_get_periodic ( kthread );
+
+	if ( kperiodic->period > 0 )
+	{
+		list_remove ( &periodic_threads, FIRST, &kperiodic->list );
+		k_admit_remove ( kthread );
+	}
+}
+
+/*!
+ * Create periodic thread; its first job is released immediately
+ * \param func Starting function
+ * \param param Parameter for starting function (and overrun handler)
+ * \param sched Scheduling policy
+ * \param prio Thread priority
+ * \param periodic Period, deadline and overrun handler
+ * \param thr_desc Where to store thread descriptor (user address)
+ */
+int sys__create_periodic_thread ( void *p )
+{
+	void *func;
+	void *param;
+	int sched, prio;
+	periodic_t *periodic;
+	thread_t *thr_desc;
+
+	kthread_t *kthread;
+	kperiodic_t *kperiodic;
+	kprocess_t *proc;
+	ktime_t period, deadline, wcet;
+
+	func = *( (void **) p ); p += sizeof (void *);
+	param = *( (void **) p ); p += sizeof (void *);
+	sched = *( (int *) p ); p += sizeof (int);
+	prio = *( (int *) p ); p += sizeof (int);
+	periodic = *( (void **) p ); p += sizeof (void *);
+	thr_desc = *( (void **) p );
+
+	proc = kthread_get_process ( NULL );
+	periodic = U2K_GET_ADR ( periodic, proc );
+	ASSERT_ERRNO_AND_EXIT ( func && periodic, E_PARAM_NULL );
+
+	if ( periodic->period.sec < 0 || periodic->period.nsec < 0 ||
+	     periodic->period.sec + periodic->period.nsec == 0 ||
+	     periodic->deadline.sec < 0 || periodic->deadline.nsec < 0 ||
+	     periodic->wcet.sec < 0 || periodic->wcet.nsec < 0 )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	period = time_to_ktime ( &periodic->period );
+	deadline = time_to_ktime ( &periodic->deadline );
+	wcet = time_to_ktime ( &periodic->wcet );
+
+	if ( k_admit_test ( NULL, ADMIT_FP, prio, period, deadline, wcet ) )
+		EXIT ( E_NOT_SCHEDULABLE );
+
+	kthread = kthread_create ( func, param, proc->pi->exit, sched, prio,
+				   NULL, 0, 1, proc );
+
+	ASSERT_ERRNO_AND_EXIT ( kthread, E_NO_MEMORY );
+
+	k_admit_add ( kthread, ADMIT_FP, kthread_get_prio ( kthread ),
+		      period, deadline, wcet );
+
+	kperiodic = kthread_get_periodic ( kthread );
+	kperiodic->period = period;
+	kperiodic->deadline = deadline;
+	if ( deadline == 0 )
+		kperiodic->deadline = period;
+	kperiodic->wcet = wcet;
+	kperiodic->release = k_get_ktime ();
+	kperiodic->waiting = FALSE;
+	kperiodic->missed = FALSE;
+	kperiodic->overrun_handler = periodic->overrun_handler;
+	kperiodic->param = param;
+	kperiodic->jobs = 1;
+	kperiodic->overruns = 0;
+
+	list_append ( &periodic_threads, kthread, &kperiodic->list );
+
+	k_periodic_arm ();
+
+	if ( thr_desc )
+	{
+		thr_desc = U2K_GET_ADR ( thr_desc, proc );
+		thr_desc->thread = kthread;
+		thr_desc->thr_id = kthread_get_id ( kthread );
+	}
+
+	SET_ERRNO ( SUCCESS );
+
+	kthreads_schedule ();
+
+	RETURN ( SUCCESS );
+}
+
+/*!
+ * Periodic thread completed its job: wait for release of next one, computed
+ * from previous release (not from current time); if that time already passed
+ * next job starts immediately
+ */
+int sys__wait_next_period ( void *p )
+{
+	kthread_t *kthread = kthread_get_active ();
+	kperiodic_t *kperiodic = kthread_get_periodic ( kthread );
+	ktime_t now;
+
+	ASSERT_ERRNO_AND_EXIT ( kperiodic->period > 0, E_INVALID_HANDLE );
+
+	now = k_get_ktime ();
+
+	/* job completed late, before alarm noticed it? */
+	if ( !kperiodic->missed &&
+	     now > kperiodic->release + kperiodic->deadline )
+		k_periodic_miss ( kthread );
+
+	kperiodic->release += kperiodic->period;
+
+	if ( kperiodic->release <= now )
+	{
+		kperiodic->missed = FALSE;
+		kperiodic->jobs++;
+	}
+	else {
+		kperiodic->waiting = TRUE;
+		kthread_enqueue ( NULL, &periodic_wait );
+	}
+
+	k_periodic_arm ();
+
+	SET_ERRNO ( SUCCESS );
+
+	kthreads_schedule ();
+
+	RETURN ( SUCCESS );
+}
+
+/*!
+ * Get periodic thread parameters and statistics
+ * \param thread Thread descriptor (user address)
+ * \param info Where to store them (user address)
+ */
+int sys__get_periodic_info ( void *p )
+{
+	thread_t *thread;
+	periodic_t *info;
+	kthread_t *kthread;
+	kperiodic_t *kperiodic;
+
+	thread = *( (void **) p ); p += sizeof (void *);
+	info = *( (void **) p );
+
+	thread = U2K_GET_ADR ( thread, kthread_get_process ( NULL ) );
+	kthread = kthread_get_descriptor ( thread );
+	ASSERT_ERRNO_AND_EXIT ( kthread, E_INVALID_HANDLE );
+
+	kperiodic = kthread_get_periodic ( kthread );
+	ASSERT_ERRNO_AND_EXIT ( kperiodic->period > 0, E_INVALID_HANDLE );
+
+	info = U2K_GET_ADR ( info, kthread_get_process ( NULL ) );
+	ASSERT_ERRNO_AND_EXIT ( info, E_PARAM_NULL );
+
+	ktime_to_time ( kperiodic->period, &info->period );
+	ktime_to_time ( kperiodic->deadline, &info->deadline );
+	ktime_to_time ( kperiodic->wcet, &info->wcet );
+	info->overrun_handler = kperiodic->overrun_handler;
+	info->jobs = kperiodic->jobs;
+	info->overruns = kperiodic->overruns;
+
+	EXIT ( SUCCESS );
+}
+
+/*! Job of periodic thread missed its deadline: count it, start handler */
+static void k_periodic_miss ( void *kthread )
+{
+	kperiodic_t *kperiodic = kthread_get_periodic ( kthread );
+	kprocess_t *proc = kthread_get_process ( kthread );
+
+	kperiodic->missed = TRUE;
+	kperiodic->overruns++;
+
+	if ( kperiodic->overrun_handler )
+		kthread_create ( kperiodic->overrun_handler, kperiodic->param,
+				 proc->pi->exit, SCHED_SERVER,
+				 kthread_get_prio ( kthread ) + 1, NULL, 0, 1,
+				 proc );
+}
+
+/*! Arm alarm for earliest release or deadline of periodic threads */
+static void k_periodic_arm ()
+{
+	kthread_t *kthread;
+	kperiodic_t *kperiodic;
+	ktime_t t, first = 0;
+	int found = FALSE;
+
+	kthread = list_get ( &periodic_threads, FIRST );
+	for ( ; kthread; kthread = list_get_next ( &kperiodic->list ) )
+	{
+		kperiodic = kthread_get_periodic ( kthread );
+		t = kperiodic->release;
+
+		if ( !kperiodic->waiting )
+		{
+			if ( kperiodic->missed )
+				continue; /* nothing until job completes */
+
+			t += kperiodic->deadline;
+		}
+
+		if ( !found || t < first )
+		{
+			first = t;
+			found = TRUE;
+		}
+	}
+
+	/* (when there is nothing to wait for, alarm is left to expire) */
+	if ( found )
+		k_alarm_rearm ( periodic_alarm, first );
+}
+
+/*! Release jobs whose time has come, detect missed deadlines */
+static void k_periodic_timer ( void *p )
+{
+	kthread_t *kthread;
+	kperiodic_t *kperiodic;
+	ktime_t now;
+
+	now = k_get_ktime ();
+
+	kthread = list_get ( &periodic_threads, FIRST );
+	for ( ; kthread; kthread = list_get_next ( &kperiodic->list ) )
+	{
+		kperiodic = kthread_get_periodic ( kthread );
+
+		if ( kperiodic->waiting )
+		{
+			if ( kperiodic->release > now )
+				continue;
+
+			kperiodic->waiting = FALSE;
+			kperiodic->missed = FALSE;
+			kperiodic->jobs++;
+
+			kthreadq_remove ( &periodic_wait, kthread );
+			kthread_move_to_ready ( kthread, LAST );
+		}
+		else if ( !kperiodic->missed &&
+			  kperiodic->release + kperiodic->deadline <= now )
+		{
+			k_periodic_miss ( kthread );
+		}
+	}
+
+	k_periodic_arm ();
+
+	kthreads_schedule ();
+}
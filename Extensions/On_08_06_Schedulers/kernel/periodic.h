@@ -0,0 +1,51 @@
+/*! Periodic threads */
+
+#pragma once
+
+/*! interface for threads (via software interrupt) -------------------------- */
+int sys__create_periodic_thread ( void *p );
+int sys__wait_next_period ( void *p );
+int sys__get_periodic_info ( void *p );
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/list.h>
+#include <lib/ktime.h>
+
+/*!
+ * Periodic thread data (included in thread descriptor; times are converted
+ * only on syscalls)
+ */
+typedef struct _kperiodic_t_
+{
+	ktime_t period;		/* zero if thread is not periodic */
+	ktime_t deadline;	/* relative to release */
+	ktime_t wcet;		/* (for admission control; may be zero) */
+	ktime_t release;	/* release of current (or next) job */
+	int waiting;		/* job completed, waiting for next release */
+	int missed;		/* current job missed its deadline */
+	void *overrun_handler;	/* user function started on deadline miss */
+	void *param;		/* its parameter */
+	uint jobs;		/* released jobs */
+	uint overruns;		/* jobs which missed deadline */
+
+	list_h list;		/* element of list of periodic threads */
+}
+kperiodic_t;
+
+/*! Interface for kernel/thread.c ------------------------------------------- */
+void k_periodic_init ();
+void k_periodic_remove ( void *kthread );
+
+#endif /* _KERNEL_ */
+
+/*! rest of the file is only for 'kernel/periodic.c' ------------------------ */
+
+#ifdef	_K_PERIODIC_C_
+
+static void k_periodic_miss ( void *kthread );
+static void k_periodic_arm ();
+static void k_periodic_timer ( void *p );
+
+#endif	/* _K_PERIODIC_C_ */
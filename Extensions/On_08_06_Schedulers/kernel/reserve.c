@@ -0,0 +1,280 @@
+/*! Processor reservations of processes */
+#define _KERNEL_
+
+/*!
+ * Process with reservation may use 'res_budget' of processor time in each
+ * 'res_period' with all its threads together (charged in kthread_account), so
+ * number of its threads doesn't multiply its share. When budget is used up,
+ * its ready threads are parked in 'res.parked' or, with RESERVE_DEMOTE, are
+ * put in processors' idle queues (they run only when nothing else is ready)
+ * until its period ends. Periods are renewed lazily, when process is charged
+ * or alarm expires. Single kernel alarm is armed for earliest period end of
+ * exhausted process or for moment when some active thread would use up its
+ * process budget. With process threads active on several processors, budget
+ * may be exceeded until that alarm.
+ */
+
+#define _K_RESERVE_C_
+#include "reserve.h"
+
+#include <arch/smp.h>
+#include <kernel/thread.h>
+#include <kernel/time.h>
+#include <kernel/memory.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+/*! Parked threads and alarm */
+static kcpu_reserve_t res;
+
+/*! Initialize parked threads queue and alarm */
+void k_reserve_init ()
+{
+	kthreadq_init ( &res.parked );
+
+	res.alarm_params.exp_time.sec = res.alarm_params.exp_time.nsec = 0;
+	res.alarm_params.period.sec = res.alarm_params.period.nsec = 0;
+	res.alarm_params.action = k_reserve_timer;
+	res.alarm_params.param = NULL;
+	res.alarm_params.flags = 0;
+
+	k_alarm_new ( &res.alarm, &res.alarm_params, KERNELCALL );
+}
+
+/*! Has process processor reservation? */
+int k_reserve_limited ( kprocess_t *proc )
+{
+	return proc->res_budget > 0;
+}
+
+/*! Must ready thread wait for next period of its process? */
+int k_reserve_waits ( kthread_t *kthread )
+{
+	kprocess_t *proc = kthread_get_process ( kthread );
+
+	return proc->res_exhausted && !( proc->res_flags & RESERVE_DEMOTE );
+}
+
+/*! Is thread demoted to background until next period of its process? */
+int k_reserve_demoted ( kthread_t *kthread )
+{
+	kprocess_t *proc = kthread_get_process ( kthread );
+
+	return proc->res_exhausted && ( proc->res_flags & RESERVE_DEMOTE );
+}
+
+/*! Queue where ready threads of exhausted processes wait for next period */
+kthread_q *k_reserve_parked ()
+{
+	return &res.parked;
+}
+
+/*! Charge time 't' used by thread of process to its reservation */
+void k_reserve_charge ( kprocess_t *proc, ktime_t t )
+{
+	if ( k_reserve_limited ( proc ) )
+		proc->res_used += t;
+}
+
+/*!
+ * Start new period of process if current one ended, otherwise check if its
+ * budget is used up; in both cases its ready threads are moved accordingly
+ */
+void k_reserve_update ( kprocess_t *proc, ktime_t now )
+{
+	if ( !k_reserve_limited ( proc ) )
+		return;
+
+	if ( now >= proc->res_period_end )
+	{
+		proc->res_used = 0;
+		proc->res_period_end = now + proc->res_period;
+
+		if ( proc->res_exhausted )
+		{
+			proc->res_exhausted = FALSE;
+			kthread_ready_list_update ( &res.parked, proc, 0 );
+		}
+	}
+	else if ( !proc->res_exhausted && proc->res_used >= proc->res_budget )
+	{
+		proc->res_exhausted = TRUE;
+		kthread_ready_list_update ( &res.parked, proc, 0 );
+		k_reserve_arm (); /* wake them at period end */
+	}
+}
+
+/*!
+ * Arm alarm for earliest period end of exhausted process or for moment when
+ * active thread would use up budget of its process (or its period ends)
+ */
+void k_reserve_arm ()
+{
+	kprocess_t *proc;
+	kthread_t *kthread;
+	ktime_t t = 0, left;
+	int i, armed = FALSE;
+
+	proc = kthread_get_next_process ( NULL );
+	for ( ; proc; proc = kthread_get_next_process ( proc ) )
+	{
+		if ( proc->res_exhausted &&
+		     ( !armed || proc->res_period_end < t ) )
+		{
+			t = proc->res_period_end;
+			armed = TRUE;
+		}
+	}
+
+	for ( i = 0; i < arch_cpu_count (); i++ )
+	{
+		kthread = kthread_get_cpu_active ( i );
+		if ( !kthread )
+			continue;
+
+		proc = kthread_get_process ( kthread );
+		if ( !k_reserve_limited ( proc ) || proc->res_exhausted )
+			continue;
+
+		/* (time since 'last_run' isn't charged yet) */
+		left = kthread_get_last_run ( kthread ) + proc->res_budget -
+		       proc->res_used;
+		if ( proc->res_period_end < left )
+			left = proc->res_period_end;
+
+		if ( !armed || left < t )
+		{
+			t = left;
+			armed = TRUE;
+		}
+	}
+
+	if ( armed )
+		k_alarm_rearm ( res.alarm, t );
+}
+
+/*! Reservation alarm: charge active threads, renew ended periods */
+static void k_reserve_timer ( void *p )
+{
+	kprocess_t *proc;
+	kthread_t *kthread;
+	ktime_t now;
+	int i;
+
+	now = k_get_ktime ();
+
+	for ( i = 0; i < arch_cpu_count (); i++ )
+	{
+		kthread = kthread_get_cpu_active ( i );
+		if ( !kthread )
+			continue;
+
+		proc = kthread_get_process ( kthread );
+		if ( k_reserve_limited ( proc ) )
+		{
+			kthread_account ( kthread, now );
+			k_reserve_update ( proc, now );
+		}
+	}
+
+	/* period may end while process has no active thread */
+	proc = kthread_get_next_process ( NULL );
+	for ( ; proc; proc = kthread_get_next_process ( proc ) )
+		if ( proc->res_exhausted )
+			k_reserve_update ( proc, now );
+
+	k_reserve_arm ();
+
+	kthreads_schedule ();
+}
+
+/*! Get process of thread given with user handle (NULL for calling thread) */
+static kprocess_t *k_reserve_process ( thread_t *thread )
+{
+	if ( !thread )
+		return kthread_get_process ( NULL );
+
+	thread = U2K_GET_ADR ( thread, kthread_get_process ( NULL ) );
+	if ( !thread || !thread->thread ||
+	     thread->thr_id != kthread_get_id ( thread->thread ) )
+		return NULL;
+
+	return kthread_get_process ( thread->thread );
+}
+
+/*!
+ * Set processor reservation of process (new period starts)
+ * \param thread Thread whose process is reserved (NULL for calling thread)
+ * \param params Budget, period and flags (user address)
+ */
+int sys__set_cpu_reserve ( void *p )
+{
+	thread_t *thread;
+	cpu_reserve_t *params;
+	kprocess_t *proc;
+
+	thread = *( (void **) p ); p += sizeof (void *);
+	params = *( (void **) p );
+
+	params = U2K_GET_ADR ( params, kthread_get_process ( NULL ) );
+	ASSERT_ERRNO_AND_EXIT ( params, E_PARAM_NULL );
+
+	proc = k_reserve_process ( thread );
+	ASSERT_ERRNO_AND_EXIT ( proc && proc != &kernel_proc,
+				E_INVALID_HANDLE );
+
+	if ( params->budget.sec < 0 || params->budget.nsec < 0 ||
+	     ( params->budget.sec + params->budget.nsec > 0 &&
+	       ( params->period.sec < 0 || params->period.nsec < 0 ||
+		 params->period.sec + params->period.nsec == 0 ||
+		 time_cmp ( &params->budget, &params->period ) > 0 ) ) )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	proc->res_budget = time_to_ktime ( &params->budget );
+	proc->res_period = time_to_ktime ( &params->period );
+	proc->res_flags = params->flags & RESERVE_DEMOTE;
+
+	/* threads of exhausted process are released: new period starts */
+	proc->res_used = 0;
+	proc->res_period_end = k_get_ktime () + proc->res_period;
+
+	if ( proc->res_exhausted )
+	{
+		proc->res_exhausted = FALSE;
+		kthread_ready_list_update ( &res.parked, proc, 0 );
+	}
+
+	SET_ERRNO ( SUCCESS );
+
+	kthreads_schedule ();
+
+	RETURN ( SUCCESS );
+}
+
+/*!
+ * Get processor reservation of process
+ * \param thread Thread whose process is queried (NULL for calling thread)
+ * \param params Where to store reservation (user address)
+ */
+int sys__get_cpu_reserve ( void *p )
+{
+	thread_t *thread;
+	cpu_reserve_t *params;
+	kprocess_t *proc;
+
+	thread = *( (void **) p ); p += sizeof (void *);
+	params = *( (void **) p );
+
+	params = U2K_GET_ADR ( params, kthread_get_process ( NULL ) );
+	ASSERT_ERRNO_AND_EXIT ( params, E_PARAM_NULL );
+
+	proc = k_reserve_process ( thread );
+	ASSERT_ERRNO_AND_EXIT ( proc, E_INVALID_HANDLE );
+
+	ktime_to_time ( proc->res_budget, &params->budget );
+	ktime_to_time ( proc->res_period, &params->period );
+	params->flags = proc->res_flags;
+	ktime_to_time ( proc->res_used, &params->used );
+
+	EXIT ( SUCCESS );
+}
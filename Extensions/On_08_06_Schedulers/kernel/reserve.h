@@ -0,0 +1,44 @@
+/*! Processor reservations of processes */
+
+#pragma once
+
+/*! interface for threads (via software interrupt) -------------------------- */
+int sys__set_cpu_reserve ( void *p );
+int sys__get_cpu_reserve ( void *p );
+
+#ifdef _KERNEL_
+
+#include <kernel/thread.h>
+#include <kernel/time.h>
+#include <lib/types.h>
+
+/*! Interface for kernel/thread.c ------------------------------------------- */
+void k_reserve_init ();
+int k_reserve_limited ( kprocess_t *proc );
+int k_reserve_waits ( kthread_t *kthread );
+int k_reserve_demoted ( kthread_t *kthread );
+kthread_q *k_reserve_parked ();
+void k_reserve_charge ( kprocess_t *proc, ktime_t t );
+void k_reserve_update ( kprocess_t *proc, ktime_t now );
+void k_reserve_arm ();
+
+#endif /* _KERNEL_ */
+
+/*! rest of the file is only for 'kernel/reserve.c' ------------------------- */
+
+#ifdef	_K_RESERVE_C_
+
+/*! Processor reservations: threads of processes waiting for next period */
+typedef struct _kcpu_reserve_t_
+{
+	kthread_q parked;	/* ready threads of exhausted processes */
+
+	void *alarm;		/* kernel alarm: period end or budget end */
+	alarm_t alarm_params;
+}
+kcpu_reserve_t;
+
+static void k_reserve_timer ( void *p );
+static kprocess_t *k_reserve_process ( thread_t *thread );
+
+#endif	/* _K_RESERVE_C_ */
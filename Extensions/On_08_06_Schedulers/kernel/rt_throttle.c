@@ -0,0 +1,281 @@
+/*! Real-time throttling */
+#define _KERNEL_
+
+/*!
+ * Threads with priority 'rt.prio' or higher are real-time ones: processor time
+ * they use is charged (kthread_account) to global and process budgets of
+ * current period. When budget is used up, its ready real-time threads are
+ * parked in 'rt.parked' (and active ones are replaced) until period ends,
+ * so that lower priority threads get at least 'period - runtime'.
+ * Kernel alarm is armed for end of period, or earlier, for moment when active
+ * real-time thread would use up its budget. With several processors running
+ * real-time threads, budget may be exceeded until that alarm.
+ */
+
+#define _K_RT_THROTTLE_C_
+#include "rt_throttle.h"
+
+#include <arch/smp.h>
+#include <kernel/thread.h>
+#include <kernel/time.h>
+#include <kernel/memory.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+/*! Global limit and state */
+static krt_throttle_t rt;
+
+/*! Set default limit: 950 ms per 1 s for priorities above default one */
+void k_rt_init ()
+{
+	rt.prio = THR_DEFAULT_PRIO + 1;
+	rt.runtime = 950000000;
+	rt.period = KTIME_SEC;
+
+	rt.used = 0;
+	rt.period_end = 0; /* first one starts later */
+	rt.throttled = rt.park = FALSE;
+
+	kthreadq_init ( &rt.parked );
+
+	rt.alarm_params.exp_time.sec = rt.alarm_params.exp_time.nsec = 0;
+	rt.alarm_params.period.sec = rt.alarm_params.period.nsec = 0;
+	rt.alarm_params.action = k_rt_timer;
+	rt.alarm_params.param = NULL;
+	rt.alarm_params.flags = 0;
+	rt.alarm_time = 0;
+
+	k_alarm_new ( &rt.alarm, &rt.alarm_params, KERNELCALL );
+}
+
+/*! Is thread real-time one (charged to real-time budgets)? */
+int k_rt_thread ( kthread_t *kthread )
+{
+	return kthread_get_prio ( kthread ) >= rt.prio;
+}
+
+/*! Is thread real-time one which must wait for next period? */
+int k_rt_throttled ( kthread_t *kthread )
+{
+	return k_rt_thread ( kthread ) &&
+		( rt.throttled || kthread_get_process ( kthread )->rt_throttled );
+}
+
+/*! Queue where throttled ready threads wait for next period */
+kthread_q *k_rt_parked ()
+{
+	return &rt.parked;
+}
+
+/*! Charge time 't' used by real-time thread to global and process budget */
+void k_rt_charge ( kthread_t *kthread, ktime_t t )
+{
+	if ( !k_rt_thread ( kthread ) )
+		return;
+
+	rt.used += t;
+	kthread_get_process ( kthread )->rt_used += t;
+}
+
+/*!
+ * Start new period if current one ended (releasing parked threads); otherwise
+ * check global limit and limit of 'kthread' process (if given)
+ */
+void k_rt_update ( kthread_t *kthread, ktime_t now )
+{
+	kprocess_t *proc;
+
+	if ( now >= rt.period_end )
+	{
+		rt.used = 0;
+		rt.throttled = rt.park = FALSE;
+
+		proc = kthread_get_next_process ( NULL );
+		for ( ; proc; proc = kthread_get_next_process ( proc ) )
+		{
+			proc->rt_used = 0;
+			proc->rt_throttled = FALSE;
+		}
+
+		rt.period_end = now + rt.period;
+
+		/* nothing is throttled now, so none is parked again */
+		while ( ( kthread = kthreadq_remove ( &rt.parked, NULL ) ) )
+			kthread_move_to_ready ( kthread, LAST );
+
+		return;
+	}
+
+	if ( !rt.throttled && rt.runtime > 0 && rt.used >= rt.runtime )
+		rt.throttled = rt.park = TRUE;
+
+	proc = kthread ? kthread_get_process ( kthread ) : NULL;
+	if ( proc && !proc->rt_throttled && proc->rt_runtime > 0 &&
+	     proc->rt_used >= proc->rt_runtime )
+		proc->rt_throttled = rt.park = TRUE;
+
+	if ( rt.park )
+		k_rt_park ();
+}
+
+/*! Park throttled ready threads; processors running such reschedule */
+static void k_rt_park ()
+{
+	rt.park = FALSE;
+
+	kthread_ready_list_update ( NULL, NULL, rt.prio );
+
+	k_rt_arm ( NULL, 0 ); /* wake them at period end */
+}
+
+/*!
+ * Arm alarm for end of period, or if real-time 'kthread' is given, for when it
+ * would reach global or process limit (if that is earlier)
+ */
+void k_rt_arm ( kthread_t *kthread, ktime_t now )
+{
+	kprocess_t *proc;
+	ktime_t t, left;
+	int limited = FALSE;
+
+	t = rt.period_end;
+
+	if ( kthread && !k_rt_throttled ( kthread ) )
+	{
+		if ( rt.runtime > 0 )
+		{
+			limited = TRUE;
+			left = now + rt.runtime - rt.used;
+			if ( left < t )
+				t = left;
+		}
+
+		proc = kthread_get_process ( kthread );
+		if ( proc->rt_runtime > 0 )
+		{
+			limited = TRUE;
+			left = now + proc->rt_runtime - proc->rt_used;
+			if ( left < t )
+				t = left;
+		}
+
+		if ( !limited )
+			return;
+	}
+
+	if ( rt.alarm_time == 0 || t < rt.alarm_time )
+	{
+		rt.alarm_time = t;
+		k_alarm_rearm ( rt.alarm, t );
+	}
+}
+
+/*! Real-time throttling alarm: charge active real-time threads */
+static void k_rt_timer ( void *p )
+{
+	kthread_t *kthread;
+	ktime_t now;
+	int i;
+
+	rt.alarm_time = 0;
+
+	now = k_get_ktime ();
+
+	for ( i = 0; i < arch_cpu_count (); i++ )
+	{
+		kthread = kthread_get_cpu_active ( i );
+		if ( kthread && k_rt_thread ( kthread ) )
+		{
+			kthread_account ( kthread, now );
+			k_rt_update ( kthread, now );
+		}
+	}
+
+	k_rt_update ( NULL, now ); /* period may end without them */
+
+	for ( i = 0; i < arch_cpu_count (); i++ )
+	{
+		kthread = kthread_get_cpu_active ( i );
+		if ( kthread && k_rt_thread ( kthread ) )
+			k_rt_arm ( kthread, now );
+	}
+
+	if ( kthreadq_get ( &rt.parked ) )
+		k_rt_arm ( NULL, 0 );
+
+	kthreads_schedule ();
+}
+
+/*!
+ * Set real-time throttling parameters (new period starts)
+ * \param params Limit (user address)
+ */
+int sys__set_rt_throttle ( void *p )
+{
+	rt_throttle_t *params;
+	kprocess_t *proc;
+	ktime_t now;
+
+	params = *( (void **) p );
+
+	proc = kthread_get_process ( NULL );
+	params = U2K_GET_ADR ( params, proc );
+	ASSERT_ERRNO_AND_EXIT ( params, E_PARAM_NULL );
+
+	if ( params->runtime.sec < 0 || params->runtime.nsec < 0 )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	if ( params->flags & RT_THROTTLE_PROC )
+	{
+		proc->rt_runtime = time_to_ktime ( &params->runtime );
+	}
+	else {
+		if ( params->prio < 1 || params->prio >= PRIO_LEVELS ||
+		     params->period.sec < 0 || params->period.nsec < 0 ||
+		     params->period.sec + params->period.nsec == 0 ||
+		     time_cmp ( &params->runtime, &params->period ) > 0 )
+			EXIT ( E_INVALID_ARGUMENT );
+
+		rt.prio = params->prio;
+		rt.runtime = time_to_ktime ( &params->runtime );
+		rt.period = time_to_ktime ( &params->period );
+	}
+
+	/* parked threads are released: new limits apply from now */
+	now = k_get_ktime ();
+	rt.period_end = now;
+	k_rt_update ( NULL, now );
+
+	SET_ERRNO ( SUCCESS );
+
+	kthreads_schedule ();
+
+	RETURN ( SUCCESS );
+}
+
+/*!
+ * Get real-time throttling parameters
+ * \param params Where to store limit (user address); with RT_THROTTLE_PROC
+ *        set in 'params->flags', process limit is returned in 'runtime'
+ */
+int sys__get_rt_throttle ( void *p )
+{
+	rt_throttle_t *params;
+	kprocess_t *proc;
+
+	params = *( (void **) p );
+
+	proc = kthread_get_process ( NULL );
+	params = U2K_GET_ADR ( params, proc );
+	ASSERT_ERRNO_AND_EXIT ( params, E_PARAM_NULL );
+
+	if ( params->flags & RT_THROTTLE_PROC )
+		ktime_to_time ( proc->rt_runtime, &params->runtime );
+	else
+		ktime_to_time ( rt.runtime, &params->runtime );
+
+	params->prio = rt.prio;
+	ktime_to_time ( rt.period, &params->period );
+
+	EXIT ( SUCCESS );
+}
@@ -0,0 +1,58 @@
+/*! Real-time throttling (limit processor time of real-time threads) */
+
+#pragma once
+
+/*! interface for threads (via software interrupt) -------------------------- */
+int sys__set_rt_throttle ( void *p );
+int sys__get_rt_throttle ( void *p );
+
+#ifdef _KERNEL_
+
+#include <kernel/thread.h>
+#include <kernel/time.h>
+#include <lib/types.h>
+
+/*! Interface for kernel/thread.c ------------------------------------------- */
+void k_rt_init ();
+int k_rt_thread ( kthread_t *kthread );
+int k_rt_throttled ( kthread_t *kthread );
+kthread_q *k_rt_parked ();
+void k_rt_charge ( kthread_t *kthread, ktime_t t );
+void k_rt_update ( kthread_t *kthread, ktime_t now );
+void k_rt_arm ( kthread_t *kthread, ktime_t now );
+
+#endif /* _KERNEL_ */
+
+/*! rest of the file is only for 'kernel/rt_throttle.c' --------------------- */
+
+#ifdef	_K_RT_THROTTLE_C_
+
+/*!
+ * Real-time throttling: processor time used by threads with priority 'prio'
+ * or higher is limited globally and per process (kprocess_t.rt_*); threads
+ * over limit are parked outside ready queues until next period (times are
+ * converted to time_t only on syscalls)
+ */
+typedef struct _krt_throttle_t_
+{
+	int prio;		/* lowest real-time priority */
+	ktime_t runtime;	/* global limit per period (zero: no limit) */
+	ktime_t period;
+
+	ktime_t used;		/* time used in current period */
+	ktime_t period_end;	/* when current period ends */
+	int throttled;		/* global limit reached in current period */
+	int park;		/* some limit reached, park ready threads */
+
+	kthread_q parked;	/* throttled ready threads */
+
+	void *alarm;		/* kernel alarm: period end or limit exhaustion */
+	alarm_t alarm_params;
+	ktime_t alarm_time;	/* when alarm is armed for (0 if not armed) */
+}
+krt_throttle_t;
+
+static void k_rt_park ();
+static void k_rt_timer ( void *p );
+
+#endif	/* _K_RT_THROTTLE_C_ */
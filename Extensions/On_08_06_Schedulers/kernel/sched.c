@@ -5,11 +5,25 @@
 #include <kernel/errno.h>
 
 extern ksched_t ksched_rr;
+extern ksched_t ksched_edf;
+extern ksched_t ksched_cfs;
+extern ksched_t ksched_mlfq;
+extern ksched_t ksched_stride;
+extern ksched_t ksched_server;
+extern ksched_t ksched_cyclic;
+extern ksched_t ksched_idle;
 
 /*! Staticaly defined schedulers (could be easily extended to dynamicaly) */
 static ksched_t *ksched[] = {
 	NULL,		/* SCHED_FIFO */
-	&ksched_rr	/* SCHED_RR */
+	&ksched_rr,	/* SCHED_RR */
+	&ksched_edf,	/* SCHED_EDF */
+	&ksched_cfs,	/* SCHED_CFS */
+	&ksched_mlfq,	/* SCHED_MLFQ */
+	&ksched_stride,	/* SCHED_STRIDE */
+	&ksched_server,	/* SCHED_SERVER */
+	&ksched_cyclic,	/* SCHED_CYCLIC */
+	&ksched_idle	/* SCHED_IDLE */
 };
 
 /*! Get pointer to ksched_t parameters for requested scheduling policy */
@@ -39,6 +53,9 @@ int ksched_set_thread_policy ( kthread_t *kthread, int new_policy )
 	ASSERT ( old_policy >= 0 && old_policy < SCHED_NUM );
 	ASSERT ( new_policy >= 0 && new_policy < SCHED_NUM );
 
+	if ( old_policy == new_policy )
+		return old_policy;
+
 	if ( ksched[old_policy] && ksched[old_policy]->thread_remove )
 		ksched[old_policy]->thread_remove ( kthread );
 
@@ -50,6 +67,41 @@ int ksched_set_thread_policy ( kthread_t *kthread, int new_policy )
 	return old_policy;
 }
 
+/*!
+ * Set thread priority as requested by user (thread); scheduler which manages
+ * thread priorities itself may use given priority differently (e.g. as weight)
+ */
+int ksched_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	int sched = kthread_get_sched_param (kthread)->sched_policy;
+
+	ASSERT ( sched >= 0 && sched < SCHED_NUM );
+
+	if ( ksched[sched] && ksched[sched]->set_thread_prio )
+		return ksched[sched]->set_thread_prio ( kthread, prio );
+
+	if ( prio != kthread_get_prio ( kthread ) )
+		kthread_set_prio ( kthread, prio );
+
+	return 0;
+}
+
+/*!
+ * Active thread is to block waiting for message or semaphore (called before
+ * it is put into queue); scheduler may e.g. lend its share to server thread
+ */
+int ksched_thread_ipc_block ( kthread_t *kthread )
+{
+	int sched = kthread_get_sched_param (kthread)->sched_policy;
+
+	ASSERT ( sched >= 0 && sched < SCHED_NUM );
+
+	if ( ksched[sched] && ksched[sched]->thread_ipc_block )
+		return ksched[sched]->thread_ipc_block ( kthread );
+
+	return 0;
+}
+
 /*! Add thread to scheduling policy (if required by policy) */
 int ksched_thread_add ( kthread_t *kthread, int sched_policy )
 {
@@ -59,6 +111,7 @@ int ksched_thread_add ( kthread_t *kthread, int sched_policy )
 
 	tsched->sched_policy = sched_policy;
 	tsched->activated = 0;
+	tsched->vruntime = 0;
 
 	if ( ksched[sched_policy] && ksched[sched_policy]->thread_add )
 		ksched[sched_policy]->thread_add ( kthread );
@@ -129,6 +182,7 @@ int sys__set_thread_sched_params ( void *p )
 	sched_t *params;
 	//other variables
 	kthread_t *kthread;
+	int retval = 0;
 
 	thread = *( (void **) p ); p += sizeof (void *);
 	thread = U2K_GET_ADR ( thread, kthread_get_process (NULL) );
@@ -138,26 +192,34 @@ int sys__set_thread_sched_params ( void *p )
 				E_INVALID_HANDLE );
 
 	sched_policy = *( (int *) p ); p += sizeof (int);
-	ASSERT_ERRNO_AND_EXIT ( sched_policy > 0 && sched_policy < SCHED_NUM,
+	ASSERT_ERRNO_AND_EXIT ( sched_policy >= 0 && sched_policy < SCHED_NUM,
 			       E_INVALID_HANDLE );
 
+	/* prio == 0 => don't change thread priority */
 	prio = *( (int *) p ); p += sizeof (int);
-	ASSERT_ERRNO_AND_EXIT ( prio > 0 && prio < PRIO_LEVELS,
+	ASSERT_ERRNO_AND_EXIT ( prio >= 0 && prio < PRIO_LEVELS,
 			       E_INVALID_HANDLE );
 
 	params = *( (void **) p ); p += sizeof (void *);
-	params = U2K_GET_ADR ( params, kthread_get_process (NULL) );
+	if ( params )
+		params = U2K_GET_ADR ( params, kthread_get_process (NULL) );
 
 	/* set new scheduling parameters */
 	ksched_set_thread_policy ( kthread, sched_policy );
-	kthread_set_prio ( kthread, prio );
+
+	if ( prio )
+		ksched_set_thread_prio ( kthread, prio );
+
+	SET_ERRNO ( SUCCESS );
 
 	if ( params && ksched[sched_policy] &&
 	     ksched[sched_policy]->set_thread_sched_parameters )
-		ksched[sched_policy]->set_thread_sched_parameters ( kthread,
-								    params );
+		retval = ksched[sched_policy]->set_thread_sched_parameters (
+							kthread, params );
 
-	return 0;
+	kthreads_schedule ();
+
+	return retval;
 }
 
 /*! Get thread scheduling parameters */
@@ -227,17 +289,38 @@ int sys__set_sched_params ( void *p )
 
 	params = *( (void **) p ); p += sizeof (void *);
 	params = U2K_GET_ADR ( params, kthread_get_process (NULL) );
+	ASSERT_ERRNO_AND_EXIT ( params, E_INVALID_ARGUMENT );
+
+	SET_ERRNO ( SUCCESS );
 
 	/* set new scheduling parameters */
 	if ( params && ksched[sched_policy] &&
 	     ksched[sched_policy]->set_sched_parameters )
-		ksched[sched_policy]->set_sched_parameters ( sched_policy,
-							     params );
+		return ksched[sched_policy]->set_sched_parameters (
+							sched_policy, params );
 	return 0;
 }
 /*! Get scheduling parameters */
 int sys__get_sched_params ( void *p )
 {
-	/* TODO */
+	//parameters on thread stack
+	int sched_policy;
+	sched_t *params;
+
+	sched_policy = *( (int *) p ); p += sizeof (int);
+	ASSERT_ERRNO_AND_EXIT ( sched_policy > 0 && sched_policy < SCHED_NUM,
+			       E_INVALID_HANDLE );
+
+	params = *( (void **) p ); p += sizeof (void *);
+	params = U2K_GET_ADR ( params, kthread_get_process (NULL) );
+	ASSERT_ERRNO_AND_EXIT ( params, E_INVALID_ARGUMENT );
+
+	SET_ERRNO ( SUCCESS );
+
+	/* get scheduling parameters */
+	if ( params && ksched[sched_policy] &&
+	     ksched[sched_policy]->get_sched_parameters )
+		return ksched[sched_policy]->get_sched_parameters (
+							sched_policy, params );
 	return 0;
 }
@@ -14,6 +14,12 @@
 
 #include <lib/types.h>
 #include <kernel/sched_rr.h>
+#include <kernel/sched_edf.h>
+#include <kernel/sched_cfs.h>
+#include <kernel/sched_mlfq.h>
+#include <kernel/sched_stride.h>
+#include <kernel/sched_server.h>
+#include <kernel/sched_cyclic.h>
 
 /*! Thread specific data/interface ------------------------------------------ */
 
@@ -21,6 +27,11 @@
 typedef union _kthread_sched_params_t_
 {
 	ksched_rr_thread_params rr;	/* Round Robin per thread data */
+	ksched_edf_thread_params edf;	/* EDF per thread data */
+	ksched_cfs_thread_params cfs;	/* CFS per thread data */
+	ksched_mlfq_thread_params mlfq;	/* MLFQ per thread data */
+	ksched_stride_thread_params stride; /* stride per thread data */
+	ksched_server_thread_params server; /* server per thread data */
 	/* add others thread scheduling parameters for other schedulers that
 	   require parameters */
 }
@@ -39,6 +50,9 @@ typedef struct _kthread_sched_data_t_
 				   calls when thread becomes active (or stop
 				   being active) */
 
+	uint64 vruntime;	/* virtual runtime (CFS) or pass (stride), key
+				   for ready threads in sorted priority level */
+
 	kthread_sched_params_t params;	/* scheduler per thread specific data */
 }
 kthread_sched_data_t; /* included in kthread descriptor */
@@ -46,6 +60,8 @@ kthread_sched_data_t; /* included in kthread descriptor */
 #include <kernel/thread.h>
 
 int ksched_set_thread_policy ( kthread_t *kthread, int new_policy );
+int ksched_set_thread_prio ( kthread_t *kthread, int prio );
+int ksched_thread_ipc_block ( kthread_t *kthread );
 
 int ksched_thread_add ( kthread_t *kthread, int sched_policy );
 int ksched_thread_remove ( kthread_t *kthread, int sched_policy );
@@ -59,7 +75,13 @@ int ksched_deactivate_thread ( kthread_t *kthread );
 /*! Union of per scheduler specific data types required */
 typedef union _ksched_params_t_
 {
-	ksched_rr_t rr;	/* Round Robin global data */
+	ksched_rr_t rr;		/* Round Robin global data */
+	ksched_edf_t edf;	/* EDF global data */
+	ksched_cfs_t cfs;	/* CFS global data */
+	ksched_mlfq_t mlfq;	/* MLFQ global data */
+	ksched_stride_t stride;	/* stride global data */
+	ksched_server_t server;	/* bandwidth server global data */
+	ksched_cyclic_t cyclic;	/* cyclic executive global data */
 	/* add others thread scheduling parameters for other schedulers that
 	   require parameters */
 }
@@ -98,6 +120,12 @@ struct _ksched_t_
 	/* get scheduler specific parameters from thread */
 	int (*get_thread_sched_parameters) ( kthread_t *, sched_t *);
 
+	/* thread requested new priority (if NULL, priority is just set) */
+	int (*set_thread_prio) ( kthread_t *, int prio );
+
+	/* active thread is to block waiting for message or semaphore */
+	int (*thread_ipc_block) ( kthread_t * );
+
 	ksched_params_t params;	/* scheduler specific data */
 };
 
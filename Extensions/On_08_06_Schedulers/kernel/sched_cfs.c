@@ -0,0 +1,278 @@
+/*! Completely Fair Scheduler */
+#define _KERNEL_
+
+/*!
+ * All CFS threads are put on single priority level ('prio') whose ready queue
+ * is sorted by threads virtual runtime (instead of FIFO), so thread that had
+ * least (weighted) processor time is selected first. Thread virtual runtime
+ * increases while thread is active, slower for threads with higher weight;
+ * weight is defined by priority requested for thread (as "nice" value,
+ * relative to THR_DEFAULT_PRIO). Active thread is preempted after 'time_slice'
+ * so that thread with smaller virtual runtime can get processor. Thread that
+ * was blocked for long time is not given more than 'wakeup_credit' advantage
+ * over others when it is activated again.
+ */
+
+#include "sched_cfs.h"
+#include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int cfs_init ( ksched_t *self );
+static int cfs_thread_add ( kthread_t *kthread );
+static int cfs_thread_remove ( kthread_t *kthread );
+static int cfs_set_sched_parameters ( int sched_policy, sched_t *params );
+static int cfs_get_sched_parameters ( int sched_policy, sched_t *params );
+static int cfs_get_thread_sched_parameters ( kthread_t *kthread,
+					     sched_t *params );
+static int cfs_set_thread_prio ( kthread_t *kthread, int prio );
+static int cfs_thread_activate ( kthread_t *kthread );
+static int cfs_thread_deactivate ( kthread_t *kthread );
+
+static void cfs_timer ( void *p );
+
+static void cfs_set_weight ( kthread_t *kthread, int prio );
+static void cfs_update_vruntime ( kthread_t *kthread );
+
+static int cfs_vruntime_cmp ( void *a, void *b );
+
+/*! weight of thread with THR_DEFAULT_PRIO priority */
+#define CFS_WEIGHT0	1024
+#define CFS_SHIFT	16
+
+/*! weights for "nice" values -20 to 19 (each step is about 10% of CPU) */
+#define CFS_NICE_MIN	-20
+#define CFS_NICE_MAX	19
+
+static const uint cfs_weights[] = {
+	/* -20 */	88761, 71755, 56483, 46273, 36291,
+	/* -15 */	29154, 23254, 18705, 14949, 11916,
+	/* -10 */	9548, 7620, 6100, 4904, 3906,
+	/*  -5 */	3121, 2501, 1991, 1586, 1277,
+	/*   0 */	1024, 820, 655, 526, 423,
+	/*   5 */	335, 272, 215, 172, 137,
+	/*  10 */	110, 87, 70, 56, 45,
+	/*  15 */	36, 29, 23, 18, 15
+};
+
+/*! staticaly defined CFS Scheduler */
+ksched_t ksched_cfs = (ksched_t)
+{
+	.sched_id =		SCHED_CFS,
+
+	.init = 		cfs_init,
+	.thread_add =		cfs_thread_add,
+	.thread_remove =	cfs_thread_remove,
+	.thread_activate =	cfs_thread_activate,
+	.thread_deactivate =	cfs_thread_deactivate,
+
+	.set_sched_parameters =		cfs_set_sched_parameters,
+	.get_sched_parameters =		cfs_get_sched_parameters,
+	.set_thread_sched_parameters =	NULL,
+	.get_thread_sched_parameters =	cfs_get_thread_sched_parameters,
+	.set_thread_prio =		cfs_set_thread_prio,
+
+	.params.cfs.prio =		THR_DEFAULT_PRIO - 2,
+	.params.cfs.time_slice =	10000000,
+	.params.cfs.wakeup_credit =	10000000
+};
+
+#define CFS	ksched_cfs.params.cfs
+
+/*! Init CFS scheduler */
+static int cfs_init ( ksched_t *self )
+{
+	self->params.cfs.min_vruntime = 0;
+
+	/* threads on CFS priority level are ordered by virtual runtime */
+	kthread_ready_list_sort ( self->params.cfs.prio, cfs_vruntime_cmp );
+
+	return 0;
+}
+
+/*!
+ * Add thread to CFS scheduler: its current priority defines its weight, while
+ * thread is moved to CFS priority level; it starts with smallest virtual
+ * runtime (as if it was running from start)
+ */
+static int cfs_thread_add ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	cfs_set_weight ( kthread, kthread_get_prio ( kthread ) );
+
+	tsched->vruntime = CFS.min_vruntime;
+	tsched->params.cfs.exec_start = k_get_ktime ();
+
+	if ( kthread_get_prio ( kthread ) != CFS.prio )
+		kthread_set_prio ( kthread, CFS.prio );
+
+	return 0;
+}
+
+/*!
+ * Remove thread from CFS scheduler; thread stays on CFS priority level until
+ * new priority is set
+ */
+static int cfs_thread_remove ( kthread_t *kthread )
+{
+	if ( kthread == kthread_get_active () )
+		cfs_update_vruntime ( kthread );
+
+	return 0;
+}
+
+/*! Set global CFS parameters */
+static int cfs_set_sched_parameters ( int sched_policy, sched_t *params )
+{
+	if ( params->cfs.time_slice.sec < 0 || ( !params->cfs.time_slice.sec &&
+	     params->cfs.time_slice.nsec <= 0 ) )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	CFS.time_slice = time_to_ktime ( &params->cfs.time_slice );
+
+	EXIT ( SUCCESS );
+}
+
+/*! Get global CFS parameters */
+static int cfs_get_sched_parameters ( int sched_policy, sched_t *params )
+{
+	ktime_to_time ( CFS.time_slice, &params->cfs.time_slice );
+	params->cfs.weight = CFS_WEIGHT0;
+
+	return 0;
+}
+
+/*! Get thread CFS parameters */
+static int cfs_get_thread_sched_parameters ( kthread_t *kthread,
+					     sched_t *params )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	ktime_to_time ( CFS.time_slice, &params->cfs.time_slice );
+	params->cfs.weight = tsched->params.cfs.weight;
+
+	return 0;
+}
+
+/*! Requested priority changes only thread weight, not its priority level */
+static int cfs_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	/* time consumed so far is accounted with previous weight */
+	if ( kthread == kthread_get_active () )
+		cfs_update_vruntime ( kthread );
+
+	cfs_set_weight ( kthread, prio );
+
+	return 0;
+}
+
+/*! Thread is selected by primary scheduler (had smallest virtual runtime) */
+static int cfs_thread_activate ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	uint64 credit = CFS.wakeup_credit;
+
+	/* limit advantage of thread which was sleeping for long time */
+	if ( tsched->vruntime + credit < CFS.min_vruntime )
+		tsched->vruntime = CFS.min_vruntime - credit;
+
+	/* others ready threads on this level have at least this vruntime */
+	if ( tsched->vruntime > CFS.min_vruntime )
+		CFS.min_vruntime = tsched->vruntime;
+
+	tsched->params.cfs.exec_start = k_get_ktime ();
+
+	/* let other threads check for smaller vruntime after 'time_slice' */
+	k_sched_timer_set ( tsched->params.cfs.exec_start + CFS.time_slice,
+			    cfs_timer, kthread );
+
+	return 0;
+}
+
+/*! Thread stopped being active - add consumed time to its virtual runtime */
+static int cfs_thread_deactivate ( kthread_t *kthread )
+{
+	kthread_q *q = kthread_get_queue ( kthread );
+
+	if ( kthread_is_ready ( kthread ) && q &&
+	     ( q->flags & KTHREADQ_SORTED ) )
+	{
+		/* already put in ready queue (e.g. on yield); it is sorted by
+		   virtual runtime, so thread is re-inserted with new one */
+		kthread_remove_from_ready ( kthread );
+		cfs_update_vruntime ( kthread );
+		kthread_move_to_ready ( kthread, LAST );
+	}
+	else {
+		cfs_update_vruntime ( kthread );
+	}
+
+	return 0;
+}
+
+/*! Time slice of active CFS thread expired */
+static void cfs_timer ( void *p )
+{
+	kthread_t *kthread = p;
+
+	if ( kthread_get_active () != kthread )
+		return; /* thread already deactivated (blocked or preempted) */
+
+	/* update before moving, ready queue is sorted by virtual runtime */
+	cfs_update_vruntime ( kthread );
+
+	kthread_move_to_ready ( kthread, LAST );
+
+	kthreads_schedule ();
+}
+
+/*! Set thread weight (and its inverse) from given priority */
+static void cfs_set_weight ( kthread_t *kthread, int prio )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	int nice = THR_DEFAULT_PRIO - prio;
+
+	if ( nice < CFS_NICE_MIN )
+		nice = CFS_NICE_MIN;
+	if ( nice > CFS_NICE_MAX )
+		nice = CFS_NICE_MAX;
+
+	tsched->params.cfs.prio = prio;
+	tsched->params.cfs.weight = cfs_weights[nice - CFS_NICE_MIN];
+	tsched->params.cfs.inv_weight = ( CFS_WEIGHT0 << CFS_SHIFT ) /
+					tsched->params.cfs.weight;
+}
+
+/*! Add time elapsed from 'exec_start' (weighted) to thread virtual runtime */
+static void cfs_update_vruntime ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	ktime_t now, delta;
+
+	now = k_get_ktime ();
+
+	delta = now - tsched->params.cfs.exec_start;
+	tsched->params.cfs.exec_start = now;
+
+	if ( delta < 0 )
+		return;
+
+	tsched->vruntime += ( (uint64) delta *
+			      tsched->params.cfs.inv_weight ) >> CFS_SHIFT;
+}
+
+/*! Compare threads by virtual runtime (ready queue order) */
+static int cfs_vruntime_cmp ( void *a, void *b )
+{
+	uint64 va = kthread_get_sched_param ( a )->vruntime;
+	uint64 vb = kthread_get_sched_param ( b )->vruntime;
+
+	if ( va < vb )
+		return -1;
+	else if ( va > vb )
+		return 1;
+	else
+		return 0;
+}
@@ -0,0 +1,36 @@
+/*! Completely Fair Scheduler (virtual runtime based) */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/ktime.h>
+
+/*! Per thread scheduler data (virtual runtime is in kthread_sched_data_t) */
+typedef struct _ksched_cfs_thread_params_
+{
+	int prio;		/* requested priority (defines weight) */
+	uint weight;		/* thread weight */
+	uint inv_weight;	/* ( CFS_WEIGHT0 << CFS_SHIFT ) / weight */
+
+	ktime_t exec_start;	/* when thread was last activated (or its
+				   virtual runtime last updated) */
+}
+ksched_cfs_thread_params;
+
+/*! CFS global parameters */
+typedef struct _ksched_cfs_t_
+{
+	int prio;		/* priority level (ready queue) of CFS threads */
+
+	ktime_t time_slice;	/* longest run before preemption by thread with
+				   smaller virtual runtime */
+	ktime_t wakeup_credit;	/* how far behind 'min_vruntime' can thread
+				   woken up after long sleep start */
+
+	uint64 min_vruntime;	/* (monotonic) smallest virtual runtime */
+}
+ksched_cfs_t;
+
+#endif /* _KERNEL_ */
@@ -0,0 +1,356 @@
+/*! Cyclic executive Scheduler */
+#define _KERNEL_
+
+/*!
+ * Time-triggered schedule: table of slots (thread, minor frame, offset and
+ * length), loaded with sys__set_sched_params, is repeated every major frame.
+ * Slot starts and ends are driven by frame timer (k_frame_timer_set), not by
+ * scheduler timer or alarms, and are calculated from major frame start, so
+ * they don't drift.
+ * - at slot start its thread gets 'prio_high' and is released (if held)
+ * - at slot end its thread, if still ready, is held in 'cyclic_wait' with
+ *   'prio_low' until its next slot
+ * - cyclic thread activated outside its slots (e.g. just created, or released
+ *   from semaphore after its slot ended) is held at once
+ */
+
+#include "sched_cyclic.h"
+#include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int cyclic_init ( ksched_t *self );
+static int cyclic_thread_add ( kthread_t *kthread );
+static int cyclic_thread_remove ( kthread_t *kthread );
+static int cyclic_set_sched_parameters ( int sched_policy, sched_t *params );
+static int cyclic_get_sched_parameters ( int sched_policy, sched_t *params );
+static int cyclic_set_thread_prio ( kthread_t *kthread, int prio );
+static int cyclic_thread_activate ( kthread_t *kthread );
+
+static void cyclic_frame_timer ( void *p );
+static void cyclic_hold_timer ( void *p );
+
+static void cyclic_slot_start ( kthread_t *kthread );
+static void cyclic_slot_end ( kthread_t *kthread );
+static void cyclic_next_boundary ();
+static int cyclic_in_slot ( kthread_t *kthread );
+
+/*! threads held outside their slots */
+static kthread_q cyclic_wait;
+
+/*! schedule table (copied from user) */
+static kcyclic_slot_t cyclic_table[CYCLIC_MAX_SLOTS];
+
+/*! staticaly defined cyclic executive Scheduler */
+ksched_t ksched_cyclic = (ksched_t)
+{
+	.sched_id =		SCHED_CYCLIC,
+
+	.init = 		cyclic_init,
+	.thread_add =		cyclic_thread_add,
+	.thread_remove =	cyclic_thread_remove,
+	.thread_activate =	cyclic_thread_activate,
+	.thread_deactivate =	NULL,
+
+	.set_sched_parameters =		cyclic_set_sched_parameters,
+	.get_sched_parameters =		cyclic_get_sched_parameters,
+	.set_thread_sched_parameters =	NULL,
+	.get_thread_sched_parameters =	NULL,
+	.set_thread_prio =		cyclic_set_thread_prio,
+
+	.params.cyclic.prio_high =	PRIO_LEVELS - 1,
+	.params.cyclic.prio_low =	1
+};
+
+#define CYCLIC	ksched_cyclic.params.cyclic
+
+/*! Init cyclic executive: no schedule until table is set */
+static int cyclic_init ( ksched_t *self )
+{
+	kthreadq_init ( &cyclic_wait );
+
+	self->params.cyclic.slots = 0;
+	self->params.cyclic.cur = 0;
+	self->params.cyclic.in_slot = FALSE;
+
+	return 0;
+}
+
+/*! Add thread to cyclic executive; it runs only in its slots */
+static int cyclic_thread_add ( kthread_t *kthread )
+{
+	kthread_set_prio ( kthread, CYCLIC.prio_low );
+
+	return 0;
+}
+
+/*!
+ * Remove thread from cyclic executive: its slots stay empty and if held it is
+ * released; thread keeps its current priority until new priority is set
+ */
+static int cyclic_thread_remove ( kthread_t *kthread )
+{
+	int i;
+
+	for ( i = 0; i < CYCLIC.slots; i++ )
+		if ( cyclic_table[i].kthread == kthread )
+			cyclic_table[i].kthread = NULL;
+
+	if ( kthread_get_queue ( kthread ) == &cyclic_wait )
+	{
+		kthreadq_remove ( &cyclic_wait, kthread );
+		kthread_move_to_ready ( kthread, LAST );
+	}
+
+	return 0;
+}
+
+/*!
+ * Set new schedule table (or stop schedule with zero slots); first major
+ * frame starts immediately
+ */
+static int cyclic_set_sched_parameters ( int sched_policy, sched_t *params )
+{
+	cyclic_slot_t *table, *slot;
+	kthread_t *kthread;
+	ktime_t minor, frame_start, start, end, prev_end;
+	int i, frame;
+
+	if ( params->cyclic.slots < 0 ||
+	     params->cyclic.slots > CYCLIC_MAX_SLOTS )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	table = NULL;
+	minor = 0;
+	if ( params->cyclic.slots > 0 )
+	{
+		if ( params->cyclic.minor.sec < 0 ||
+		     params->cyclic.minor.nsec < 0 ||
+		     params->cyclic.minor.sec + params->cyclic.minor.nsec == 0 ||
+		     params->cyclic.frames < 1 )
+			EXIT ( E_INVALID_ARGUMENT );
+
+		minor = time_to_ktime ( &params->cyclic.minor );
+
+		table = U2K_GET_ADR ( params->cyclic.table,
+				      kthread_get_process ( NULL ) );
+		ASSERT_ERRNO_AND_EXIT ( table, E_INVALID_ARGUMENT );
+	}
+
+	/* check slots: valid threads, ordered, not overlapping */
+	frame = 0;
+	frame_start = prev_end = 0;
+	for ( i = 0; i < params->cyclic.slots; i++ )
+	{
+		slot = &table[i];
+		kthread = slot->thread.thread;
+
+		ASSERT_ERRNO_AND_EXIT ( kthread && slot->thread.thr_id ==
+					kthread_get_id ( kthread ),
+					E_INVALID_HANDLE );
+		ASSERT_ERRNO_AND_EXIT ( kthread_get_sched_param ( kthread )->
+					sched_policy == SCHED_CYCLIC,
+					E_INVALID_ARGUMENT );
+
+		if ( slot->frame < frame || slot->frame >= params->cyclic.frames ||
+		     slot->offset.sec < 0 || slot->offset.nsec < 0 ||
+		     slot->length.sec < 0 || slot->length.nsec < 0 ||
+		     slot->length.sec + slot->length.nsec == 0 )
+			EXIT ( E_INVALID_ARGUMENT );
+
+		start = time_to_ktime ( &slot->offset );
+		end = start + time_to_ktime ( &slot->length );
+		if ( end > minor )
+			EXIT ( E_INVALID_ARGUMENT ); /* crosses frame boundary */
+
+		for ( ; frame < slot->frame; frame++ )
+			frame_start += minor;
+
+		start += frame_start;
+		end += frame_start;
+
+		if ( start < prev_end )
+			EXIT ( E_INVALID_ARGUMENT ); /* not ordered */
+
+		prev_end = end;
+	}
+
+	/* stop current schedule */
+	k_frame_timer_set ( 0, NULL, NULL );
+	if ( CYCLIC.slots && CYCLIC.in_slot )
+		cyclic_slot_end ( cyclic_table[CYCLIC.cur].kthread );
+
+	CYCLIC.slots = params->cyclic.slots;
+	CYCLIC.cur = 0;
+	CYCLIC.in_slot = FALSE;
+
+	if ( CYCLIC.slots )
+	{
+		CYCLIC.minor = minor;
+		CYCLIC.frames = params->cyclic.frames;
+		CYCLIC.major = minor * CYCLIC.frames;
+
+		frame = 0;
+		frame_start = 0;
+		for ( i = 0; i < CYCLIC.slots; i++ )
+		{
+			for ( ; frame < table[i].frame; frame++ )
+				frame_start += minor;
+
+			cyclic_table[i].kthread = table[i].thread.thread;
+			cyclic_table[i].frame = table[i].frame;
+			cyclic_table[i].start = frame_start +
+					time_to_ktime ( &table[i].offset );
+			cyclic_table[i].end = cyclic_table[i].start +
+					time_to_ktime ( &table[i].length );
+		}
+
+		CYCLIC.major_start = k_get_ktime ();
+		cyclic_next_boundary ();
+		k_frame_timer_set ( CYCLIC.next, cyclic_frame_timer, NULL );
+	}
+
+	SET_ERRNO ( SUCCESS );
+
+	kthreads_schedule ();
+
+	RETURN ( SUCCESS );
+}
+
+/*! Get cyclic executive parameters (without table) */
+static int cyclic_get_sched_parameters ( int sched_policy, sched_t *params )
+{
+	ktime_to_time ( CYCLIC.minor, &params->cyclic.minor );
+	params->cyclic.frames = CYCLIC.frames;
+	params->cyclic.table = NULL;
+	params->cyclic.slots = CYCLIC.slots;
+
+	if ( CYCLIC.slots )
+		params->cyclic.frame = cyclic_table[CYCLIC.cur].frame;
+	else
+		params->cyclic.frame = 0;
+
+	return 0;
+}
+
+/*! Priority of cyclic thread is defined by schedule; requested is ignored */
+static int cyclic_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	return 0;
+}
+
+/*! Thread activated outside its slots is held (from scheduler timer) */
+static int cyclic_thread_activate ( kthread_t *kthread )
+{
+	if ( !cyclic_in_slot ( kthread ) )
+		k_sched_timer_set ( k_get_ktime (), cyclic_hold_timer,
+				    kthread );
+
+	return 0;
+}
+
+/*! Frame boundary: end current slot and/or start next one */
+static void cyclic_frame_timer ( void *p )
+{
+	ktime_t now;
+
+	if ( !CYCLIC.slots )
+		return;
+
+	now = k_get_ktime ();
+
+	/* boundary timer expired for is processed even if timer was a bit
+	   early; later ones (e.g. start of slot directly following) if due */
+	do {
+		if ( CYCLIC.in_slot )
+		{
+			cyclic_slot_end ( cyclic_table[CYCLIC.cur].kthread );
+			CYCLIC.in_slot = FALSE;
+
+			if ( ++CYCLIC.cur == CYCLIC.slots )
+			{
+				CYCLIC.cur = 0;
+				CYCLIC.major_start += CYCLIC.major;
+			}
+		}
+		else {
+			cyclic_slot_start ( cyclic_table[CYCLIC.cur].kthread );
+			CYCLIC.in_slot = TRUE;
+		}
+
+		cyclic_next_boundary ();
+	}
+	while ( CYCLIC.next <= now );
+
+	k_frame_timer_set ( CYCLIC.next, cyclic_frame_timer, NULL );
+
+	kthreads_schedule ();
+}
+
+/*! Cyclic thread is active outside its slots - hold it */
+static void cyclic_hold_timer ( void *p )
+{
+	kthread_t *kthread = p;
+
+	if ( kthread_get_active () != kthread || cyclic_in_slot ( kthread ) )
+		return; /* thread already deactivated or its slot started */
+
+	cyclic_slot_end ( kthread );
+
+	kthreads_schedule ();
+}
+
+/*! Slot starts: thread gets processor (if ready) */
+static void cyclic_slot_start ( kthread_t *kthread )
+{
+	if ( !kthread )
+		return; /* empty slot */
+
+	kthread_set_prio ( kthread, CYCLIC.prio_high );
+
+	if ( kthread_get_queue ( kthread ) == &cyclic_wait )
+	{
+		kthreadq_remove ( &cyclic_wait, kthread );
+		kthread_move_to_ready ( kthread, LAST );
+	}
+}
+
+/*!
+ * Slot ended: hold thread until its next slot, if it is still active or
+ * ready; blocked thread is left in its queue (with low priority)
+ */
+static void cyclic_slot_end ( kthread_t *kthread )
+{
+	if ( !kthread )
+		return;
+
+	if ( kthread == kthread_get_active () )
+	{
+		kthread_enqueue ( kthread, &cyclic_wait );
+	}
+	else if ( kthread_is_ready ( kthread ) )
+	{
+		kthread_remove_from_ready ( kthread );
+		kthread_enqueue ( kthread, &cyclic_wait );
+	}
+
+	kthread_set_prio ( kthread, CYCLIC.prio_low );
+}
+
+/*! Calculate time of next boundary: end of current or start of next slot */
+static void cyclic_next_boundary ()
+{
+	if ( CYCLIC.in_slot )
+		CYCLIC.next = CYCLIC.major_start + cyclic_table[CYCLIC.cur].end;
+	else
+		CYCLIC.next = CYCLIC.major_start +
+			      cyclic_table[CYCLIC.cur].start;
+}
+
+/*! Is thread's slot in progress? */
+static int cyclic_in_slot ( kthread_t *kthread )
+{
+	return CYCLIC.slots && CYCLIC.in_slot &&
+		cyclic_table[CYCLIC.cur].kthread == kthread;
+}
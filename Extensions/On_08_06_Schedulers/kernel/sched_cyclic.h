@@ -0,0 +1,41 @@
+/*! Cyclic executive scheduler (time-triggered schedule table) */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/ktime.h>
+
+/*!
+ * Slot of schedule table (times are relative to major frame start; all times
+ * are converted only on syscalls)
+ */
+typedef struct _kcyclic_slot_t_
+{
+	void *kthread;		/* thread running in slot (NULL if removed) */
+	int frame;		/* minor frame index */
+	ktime_t start;		/* slot start */
+	ktime_t end;		/* slot end */
+}
+kcyclic_slot_t;
+
+/*! Cyclic executive global parameters */
+typedef struct _ksched_cyclic_t_
+{
+	ktime_t minor;		/* minor frame length */
+	int frames;		/* minor frames in major frame */
+	ktime_t major;		/* major frame length (minor * frames) */
+	int slots;		/* slots in schedule table (zero: stopped) */
+
+	int prio_high;		/* priority of thread in its slot */
+	int prio_low;		/* priority of threads outside their slots */
+
+	int cur;		/* current (or next) slot */
+	int in_slot;		/* is slot 'cur' in progress? */
+	ktime_t major_start;	/* start of current major frame */
+	ktime_t next;		/* next frame boundary (slot start or end) */
+}
+ksched_cyclic_t;
+
+#endif /* _KERNEL_ */
@@ -0,0 +1,437 @@
+/*! Earliest Deadline First Scheduler */
+#define _KERNEL_
+
+/*!
+ * EDF threads are periodic: each period new job is released with its absolute
+ * deadline. Threads with active jobs are kept in list sorted by deadlines and
+ * are given priorities from 'prio_high' (earliest deadline) down to 'prio_low'
+ * (primary scheduler then does the rest). When job is completed (thread calls
+ * set_sched_params with EDF_WAIT), thread is blocked until its next release.
+ * If 'wcet' is set and job exceeds it, thread is demoted to 'prio_low' until
+ * its next job (so it can't jeopardize deadlines of other threads).
+ */
+
+#include "sched_edf.h"
+#include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/admission.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int edf_init ( ksched_t *self );
+static int edf_thread_add ( kthread_t *kthread );
+static int edf_thread_remove ( kthread_t *kthread );
+static int edf_set_thread_sched_parameters ( kthread_t *kthread,
+					     sched_t *params );
+static int edf_get_thread_sched_parameters ( kthread_t *kthread,
+					     sched_t *params );
+static int edf_thread_activate ( kthread_t *kthread );
+static int edf_thread_deactivate ( kthread_t *kthread );
+
+static void edf_release_timer ( void *p );
+static void edf_budget_timer ( void *p );
+
+static void edf_new_job ( kthread_t *kthread, ktime_t release );
+static void edf_wait_release ( kthread_t *kthread );
+static void edf_arm_release ();
+static void edf_set_priorities ();
+
+static int edf_deadline_cmp ( void *a, void *b );
+static int edf_release_cmp ( void *a, void *b );
+
+/*! threads blocked until their next release */
+static kthread_q edf_wait;
+
+/*! staticaly defined EDF Scheduler */
+ksched_t ksched_edf = (ksched_t)
+{
+	.sched_id =		SCHED_EDF,
+
+	.init = 		edf_init,
+	.thread_add =		edf_thread_add,
+	.thread_remove =	edf_thread_remove,
+	.thread_activate =	edf_thread_activate,
+	.thread_deactivate =	edf_thread_deactivate,
+
+	.set_sched_parameters =		NULL,
+	.get_sched_parameters =		NULL,
+	.set_thread_sched_parameters =	edf_set_thread_sched_parameters,
+	.get_thread_sched_parameters =	edf_get_thread_sched_parameters,
+
+	.params.edf.prio_high =		PRIO_LEVELS - 1,
+	.params.edf.prio_low =		THR_DEFAULT_PRIO + 1,
+	.params.edf.min_budget =	1000000
+};
+
+#define EDF	ksched_edf.params.edf
+
+/*! Init EDF scheduler */
+static int edf_init ( ksched_t *self )
+{
+	list_init ( &self->params.edf.jobs );
+	list_init ( &self->params.edf.releases );
+	kthreadq_init ( &edf_wait );
+
+	self->params.edf.ranking = FALSE;
+	self->params.edf.rerank = FALSE;
+
+	/* reserve an empty alarm */
+	self->params.edf.release.exp_time.sec = 0;
+	self->params.edf.release.exp_time.nsec = 0;
+	self->params.edf.release.period.sec = 0;
+	self->params.edf.release.period.nsec = 0;
+	self->params.edf.release.action = edf_release_timer;
+	self->params.edf.release.param = NULL;
+	self->params.edf.release.flags = 0;
+
+	k_alarm_new ( &self->params.edf.release_alarm,
+		      &self->params.edf.release, KERNELCALL );
+
+	return 0;
+}
+
+/*! Add thread to EDF scheduler (it is not periodic until parameters are set) */
+static int edf_thread_add ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.edf.state = EDF_T_NONE;
+	tsched->params.edf.overrun = FALSE;
+	tsched->params.edf.period = 0;
+	tsched->params.edf.deadline = tsched->params.edf.wcet = 0;
+
+	return 0;
+}
+
+/*! Remove thread from EDF scheduler (policy changed or thread canceled) */
+static int edf_thread_remove ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	k_admit_remove ( kthread );
+
+	if ( tsched->params.edf.state == EDF_T_JOB )
+	{
+		list_remove ( &EDF.jobs, FIRST, &tsched->params.edf.list );
+	}
+	else if ( tsched->params.edf.state == EDF_T_WAIT )
+	{
+		/* stop waiting for release */
+		list_remove ( &EDF.releases, FIRST, &tsched->params.edf.list );
+		kthreadq_remove ( &edf_wait, kthread );
+		kthread_move_to_ready ( kthread, LAST );
+		edf_arm_release ();
+	}
+
+	tsched->params.edf.state = EDF_T_NONE;
+
+	edf_set_priorities ();
+
+	return 0;
+}
+
+/*!
+ * Set thread EDF parameters (EDF_SET) or mark its current job as completed
+ * (EDF_WAIT)
+ */
+static int edf_set_thread_sched_parameters ( kthread_t *kthread,
+					     sched_t *params )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	ktime_t now, period, deadline, wcet;
+
+	if ( params->edf.flags & EDF_SET )
+	{
+		period = time_to_ktime ( &params->edf.period );
+		deadline = time_to_ktime ( &params->edf.deadline );
+		wcet = time_to_ktime ( &params->edf.wcet );
+
+		ASSERT_ERRNO_AND_EXIT ( period > 0, E_INVALID_ARGUMENT );
+
+		/* thread with given WCET must pass admission test */
+		ASSERT_ERRNO_AND_EXIT ( !k_admit_test ( kthread, ADMIT_EDF, 0,
+					period, deadline, wcet ),
+					E_NOT_SCHEDULABLE );
+		k_admit_add ( kthread, ADMIT_EDF, 0, period, deadline, wcet );
+
+		tsched->params.edf.period = period;
+		tsched->params.edf.wcet = wcet;
+
+		if ( deadline > 0 )
+			tsched->params.edf.deadline = deadline;
+		else
+			tsched->params.edf.deadline = period;
+
+		/* (re)start periodic execution with new job, starting now */
+		if ( tsched->params.edf.state == EDF_T_JOB )
+		{
+			list_remove ( &EDF.jobs, FIRST,
+				      &tsched->params.edf.list );
+		}
+		else if ( tsched->params.edf.state == EDF_T_WAIT )
+		{
+			list_remove ( &EDF.releases, FIRST,
+				      &tsched->params.edf.list );
+			kthreadq_remove ( &edf_wait, kthread );
+			kthread_move_to_ready ( kthread, LAST );
+			edf_arm_release ();
+		}
+
+		now = k_get_ktime ();
+		tsched->params.edf.exec_start = now;
+		edf_new_job ( kthread, now );
+
+		edf_set_priorities ();
+	}
+
+	if ( params->edf.flags & EDF_WAIT )
+	{
+		ASSERT_ERRNO_AND_EXIT ( kthread == kthread_get_active () &&
+					tsched->params.edf.state == EDF_T_JOB,
+					E_INVALID_ARGUMENT );
+
+		edf_wait_release ( kthread );
+	}
+
+	return 0;
+}
+
+/*! Get thread EDF parameters */
+static int edf_get_thread_sched_parameters ( kthread_t *kthread,
+					     sched_t *params )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	ktime_to_time ( tsched->params.edf.period, &params->edf.period );
+	ktime_to_time ( tsched->params.edf.deadline, &params->edf.deadline );
+	ktime_to_time ( tsched->params.edf.wcet, &params->edf.wcet );
+	params->edf.flags = 0;
+
+	return 0;
+}
+
+/*! Thread becomes active: start measuring its execution time */
+static int edf_thread_activate ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	ktime_t budget;
+
+	tsched->params.edf.exec_start = k_get_ktime ();
+
+	if ( tsched->params.edf.state != EDF_T_JOB ||
+	     tsched->params.edf.overrun || !tsched->params.edf.wcet )
+		return 0;
+
+	/* set scheduler timer for the rest of job budget */
+	budget = tsched->params.edf.wcet - tsched->params.edf.exec;
+
+	if ( budget < EDF.min_budget )
+		budget = EDF.min_budget;
+
+	k_sched_timer_set ( tsched->params.edf.exec_start + budget,
+			    edf_budget_timer, kthread );
+
+	return 0;
+}
+
+/*! Thread stops being active: add consumed time to its job */
+static int edf_thread_deactivate ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	if ( tsched->params.edf.state == EDF_T_JOB )
+		tsched->params.edf.exec += k_get_ktime () -
+					   tsched->params.edf.exec_start;
+
+	return 0;
+}
+
+/*! Alarm for job releases: release all threads whose period started */
+static void edf_release_timer ( void *p )
+{
+	kthread_t *kthread;
+	kthread_sched_data_t *tsched;
+	ktime_t now;
+
+	now = k_get_ktime ();
+
+	/* first in list is released even if alarm expired little earlier */
+	kthread = list_get ( &EDF.releases, FIRST );
+	while ( kthread )
+	{
+		tsched = kthread_get_sched_param ( kthread );
+
+		list_remove ( &EDF.releases, FIRST, &tsched->params.edf.list );
+		kthreadq_remove ( &edf_wait, kthread );
+		kthread_move_to_ready ( kthread, LAST );
+
+		edf_new_job ( kthread, tsched->params.edf.next_release );
+
+		kthread = list_get ( &EDF.releases, FIRST );
+		if ( kthread )
+		{
+			tsched = kthread_get_sched_param ( kthread );
+			if ( tsched->params.edf.next_release > now )
+				break;
+		}
+	}
+
+	edf_arm_release ();
+	edf_set_priorities ();
+
+	kthreads_schedule ();
+}
+
+/*! Timer for budget overrun: demote thread until its next job */
+static void edf_budget_timer ( void *p )
+{
+	kthread_t *kthread = p;
+	kthread_sched_data_t *tsched;
+
+	if ( kthread_get_active () != kthread )
+		return; /* budget timer from previous activation */
+
+	tsched = kthread_get_sched_param ( kthread );
+
+	if ( tsched->sched_policy != SCHED_EDF ||
+	     tsched->params.edf.state != EDF_T_JOB )
+		return;
+
+	tsched->params.edf.overrun = TRUE;
+
+	edf_set_priorities ();
+}
+
+/*! Start new job for thread (thread must not be in any EDF list) */
+static void edf_new_job ( kthread_t *kthread, ktime_t release )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.edf.release = release;
+	tsched->params.edf.abs_deadline = release + tsched->params.edf.deadline;
+	tsched->params.edf.next_release = release + tsched->params.edf.period;
+
+	tsched->params.edf.exec = 0;
+	tsched->params.edf.overrun = FALSE;
+	tsched->params.edf.state = EDF_T_JOB;
+
+	list_sort_add ( &EDF.jobs, kthread, &tsched->params.edf.list,
+			edf_deadline_cmp );
+}
+
+/*! Job is completed; block active thread until its next release */
+static void edf_wait_release ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	list_remove ( &EDF.jobs, FIRST, &tsched->params.edf.list );
+
+	if ( tsched->params.edf.next_release <= k_get_ktime () )
+	{
+		/* next period already started (job overrun) - don't wait */
+		edf_new_job ( kthread, tsched->params.edf.next_release );
+		edf_set_priorities ();
+		return;
+	}
+
+	tsched->params.edf.state = EDF_T_WAIT;
+	list_sort_add ( &EDF.releases, kthread, &tsched->params.edf.list,
+			edf_release_cmp );
+
+	kthread_enqueue ( kthread, &edf_wait );
+
+	edf_arm_release ();
+	edf_set_priorities ();
+
+	kthreads_schedule ();
+}
+
+/*! Set release alarm to first release time (or disable it if none) */
+static void edf_arm_release ()
+{
+	kthread_t *kthread;
+	kthread_sched_data_t *tsched;
+
+	kthread = list_get ( &EDF.releases, FIRST );
+	if ( kthread )
+	{
+		tsched = kthread_get_sched_param ( kthread );
+		ktime_to_time ( tsched->params.edf.next_release,
+				&EDF.release.exp_time );
+	}
+	else {
+		EDF.release.exp_time.sec = EDF.release.exp_time.nsec = 0;
+	}
+
+	k_alarm_set ( EDF.release_alarm, &EDF.release );
+}
+
+/*!
+ * Give priorities to threads with active jobs by their deadlines: earliest
+ * gets 'prio_high', next 'prio_high - 1', ... (but not less than 'prio_low')
+ */
+static void edf_set_priorities ()
+{
+	kthread_t *kthread, *next;
+	kthread_sched_data_t *tsched;
+	int prio, new_prio;
+
+	if ( EDF.ranking )
+	{
+		/* called while changing priorities (e.g. from alarm) */
+		EDF.rerank = TRUE;
+		return;
+	}
+
+	EDF.ranking = TRUE;
+
+	do {
+		EDF.rerank = FALSE;
+
+		prio = EDF.prio_high;
+		kthread = list_get ( &EDF.jobs, FIRST );
+		while ( kthread && !EDF.rerank )
+		{
+			tsched = kthread_get_sched_param ( kthread );
+			next = list_get_next ( &tsched->params.edf.list );
+
+			if ( tsched->params.edf.overrun )
+			{
+				new_prio = EDF.prio_low;
+			}
+			else {
+				new_prio = prio;
+				if ( prio > EDF.prio_low )
+					prio--;
+			}
+
+			if ( kthread_get_prio ( kthread ) != new_prio )
+				kthread_set_prio ( kthread, new_prio );
+
+			kthread = next;
+		}
+	}
+	while ( EDF.rerank );
+
+	EDF.ranking = FALSE;
+}
+
+/*! Compare threads by absolute deadlines of their jobs */
+static int edf_deadline_cmp ( void *a, void *b )
+{
+	kthread_sched_data_t *ta = kthread_get_sched_param ( a );
+	kthread_sched_data_t *tb = kthread_get_sched_param ( b );
+
+	return ktime_cmp ( ta->params.edf.abs_deadline,
+			   tb->params.edf.abs_deadline );
+}
+
+/*! Compare threads by their next release times */
+static int edf_release_cmp ( void *a, void *b )
+{
+	kthread_sched_data_t *ta = kthread_get_sched_param ( a );
+	kthread_sched_data_t *tb = kthread_get_sched_param ( b );
+
+	return ktime_cmp ( ta->params.edf.next_release,
+			   tb->params.edf.next_release );
+}
@@ -0,0 +1,60 @@
+/*! Earliest Deadline First scheduler */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/list.h>
+#include <lib/ktime.h>
+
+/*! Per thread scheduler data (times are converted only on syscalls) */
+typedef struct _ksched_edf_thread_params_
+{
+	ktime_t period;		/* period of job releases */
+	ktime_t deadline;	/* relative deadline (from job release) */
+	ktime_t wcet;		/* worst case execution time (job budget) */
+
+	ktime_t release;	/* current job release time (absolute) */
+	ktime_t abs_deadline;	/* current job deadline (absolute) */
+	ktime_t next_release;	/* next job release time (absolute) */
+
+	ktime_t exec;		/* execution time consumed by current job */
+	ktime_t exec_start;	/* when thread was last activated */
+
+	int state;		/* EDF_T_NONE, EDF_T_JOB or EDF_T_WAIT */
+	int overrun;		/* current job exceeded its 'wcet' budget */
+
+	list_h list;		/* element of 'jobs' or 'releases' list */
+}
+ksched_edf_thread_params;
+
+/*! EDF thread states */
+enum {
+	EDF_T_NONE = 0,	/* EDF parameters not yet set */
+	EDF_T_JOB,	/* job released and not yet completed */
+	EDF_T_WAIT	/* job completed, waiting for next release */
+};
+
+/*! EDF global parameters */
+typedef struct _ksched_edf_t_
+{
+	int prio_high;		/* priority for thread with earliest deadline */
+	int prio_low;		/* lowest priority EDF threads are given */
+
+	ktime_t min_budget;	/* shortest interval budget timer is set to */
+
+	list_t jobs;		/* threads with active jobs, sorted by
+				   absolute deadline */
+	list_t releases;	/* threads waiting for next release, sorted
+				   by release time */
+
+	void *release_alarm;	/* kernel alarm for job releases */
+	alarm_t release;	/* release alarm parameters */
+
+	int ranking;		/* priorities are being (re)assigned */
+	int rerank;		/* repeat priority assignment */
+}
+ksched_edf_t;
+
+#endif /* _KERNEL_ */
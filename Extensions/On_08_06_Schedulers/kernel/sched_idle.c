@@ -0,0 +1,53 @@
+/*! Idle scheduling class */
+#define _KERNEL_
+
+/*!
+ * SCHED_IDLE threads run only when no other thread is ready on processor
+ * (background work, e.g. flushing logs or collecting statistics). They have
+ * priority 0 and are not kept in priority ready queues, but in separate
+ * processor queue (thread.c) from which thread is taken before idle thread,
+ * so any other ready thread preempts them. Requested priority is ignored;
+ * thread which leaves idle class stays on priority 0 until new priority is
+ * set. Priority inherited over monitor moves thread into ordinary ready queue,
+ * so threads waiting for it aren't blocked by foreground work.
+ */
+
+#include <kernel/sched.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int idle_thread_add ( kthread_t *kthread );
+static int idle_set_thread_prio ( kthread_t *kthread, int prio );
+
+/*! staticaly defined idle class Scheduler */
+ksched_t ksched_idle = (ksched_t)
+{
+	.sched_id =		SCHED_IDLE,
+
+	.init = 		NULL,
+	.thread_add =		idle_thread_add,
+	.thread_remove =	NULL,
+	.thread_activate =	NULL,
+	.thread_deactivate =	NULL,
+
+	.set_sched_parameters =		NULL,
+	.get_sched_parameters =		NULL,
+	.set_thread_sched_parameters =	NULL,
+	.get_thread_sched_parameters =	NULL,
+	.set_thread_prio =		idle_set_thread_prio
+};
+
+/*! Add thread to idle class: move it below all other threads */
+static int idle_thread_add ( kthread_t *kthread )
+{
+	if ( kthread_get_prio ( kthread ) != 0 )
+		kthread_set_prio ( kthread, 0 );
+
+	return 0;
+}
+
+/*! Idle class threads stay on priority 0 */
+static int idle_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	return 0;
+}
@@ -0,0 +1,323 @@
+/*! Multi-level feedback queue Scheduler */
+#define _KERNEL_
+
+/*!
+ * Each MLFQ thread is given priority it requested (its highest level) and up
+ * to 'levels - 1' priorities below it. Thread starts on highest level with
+ * quantum 'time_slice'; on each lower level quantum is twice longer.
+ * - thread which uses whole quantum (CPU bound) is demoted one level
+ * - thread which blocks before using half of its quantum (interactive, e.g.
+ *   waiting for keyboard) is promoted one level
+ * - thread preempted by higher priority thread keeps rest of its quantum
+ * - every 'boost_period' all threads are returned to their highest level,
+ *   so that demoted threads can't starve (aging)
+ * Levels are implemented by changing thread priority (kthread_set_prio).
+ */
+
+#include "sched_mlfq.h"
+#include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int mlfq_init ( ksched_t *self );
+static int mlfq_thread_add ( kthread_t *kthread );
+static int mlfq_thread_remove ( kthread_t *kthread );
+static int mlfq_set_sched_parameters ( int sched_policy, sched_t *params );
+static int mlfq_get_sched_parameters ( int sched_policy, sched_t *params );
+static int mlfq_get_thread_sched_parameters ( kthread_t *kthread,
+					      sched_t *params );
+static int mlfq_set_thread_prio ( kthread_t *kthread, int prio );
+static int mlfq_thread_activate ( kthread_t *kthread );
+static int mlfq_thread_deactivate ( kthread_t *kthread );
+
+static void mlfq_timer ( void *p );
+static void mlfq_boost_timer ( void *p );
+
+static void mlfq_set_level ( kthread_t *kthread, int level );
+static ktime_t mlfq_quantum ( int level );
+static void mlfq_arm_boost ();
+
+/*! staticaly defined MLFQ Scheduler */
+ksched_t ksched_mlfq = (ksched_t)
+{
+	.sched_id =		SCHED_MLFQ,
+
+	.init = 		mlfq_init,
+	.thread_add =		mlfq_thread_add,
+	.thread_remove =	mlfq_thread_remove,
+	.thread_activate =	mlfq_thread_activate,
+	.thread_deactivate =	mlfq_thread_deactivate,
+
+	.set_sched_parameters =		mlfq_set_sched_parameters,
+	.get_sched_parameters =		mlfq_get_sched_parameters,
+	.set_thread_sched_parameters =	NULL,
+	.get_thread_sched_parameters =	mlfq_get_thread_sched_parameters,
+	.set_thread_prio =		mlfq_set_thread_prio,
+
+	.params.mlfq.levels =		4,
+	.params.mlfq.time_slice =	10000000,
+	.params.mlfq.boost_period =	KTIME_SEC
+};
+
+#define MLFQ	ksched_mlfq.params.mlfq
+
+/*! Init MLFQ scheduler */
+static int mlfq_init ( ksched_t *self )
+{
+	list_init ( &self->params.mlfq.threads );
+
+	/* reserve an empty alarm (armed when first thread is added) */
+	self->params.mlfq.boost.exp_time.sec = 0;
+	self->params.mlfq.boost.exp_time.nsec = 0;
+	ktime_to_time ( self->params.mlfq.boost_period,
+			&self->params.mlfq.boost.period );
+	self->params.mlfq.boost.action = mlfq_boost_timer;
+	self->params.mlfq.boost.param = NULL;
+	self->params.mlfq.boost.flags = ALARM_PERIODIC;
+
+	k_alarm_new ( &self->params.mlfq.boost_alarm,
+		      &self->params.mlfq.boost, KERNELCALL );
+
+	return 0;
+}
+
+/*! Add thread to MLFQ scheduler: its current priority is its highest level */
+static int mlfq_thread_add ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.mlfq.prio = kthread_get_prio ( kthread );
+	tsched->params.mlfq.level = 0;
+	tsched->params.mlfq.remainder = mlfq_quantum ( 0 );
+
+	list_append ( &MLFQ.threads, kthread, &tsched->params.mlfq.list );
+
+	if ( list_get ( &MLFQ.threads, FIRST ) == kthread )
+		mlfq_arm_boost ();
+
+	return 0;
+}
+
+/*!
+ * Remove thread from MLFQ scheduler; thread stays on its current level until
+ * new priority is set
+ */
+static int mlfq_thread_remove ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	list_remove ( &MLFQ.threads, FIRST, &tsched->params.mlfq.list );
+
+	if ( !list_get ( &MLFQ.threads, FIRST ) )
+		mlfq_arm_boost ();
+
+	return 0;
+}
+
+/*! Set global MLFQ parameters */
+static int mlfq_set_sched_parameters ( int sched_policy, sched_t *params )
+{
+	if ( params->mlfq.time_slice.sec < 0 ||
+	     ( !params->mlfq.time_slice.sec &&
+	       params->mlfq.time_slice.nsec <= 0 ) ||
+	     params->mlfq.boost_period.sec < 0 ||
+	     params->mlfq.boost_period.nsec < 0 ||
+	     params->mlfq.levels < 1 || params->mlfq.levels >= PRIO_LEVELS )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	MLFQ.time_slice = time_to_ktime ( &params->mlfq.time_slice );
+	MLFQ.boost_period = time_to_ktime ( &params->mlfq.boost_period );
+	MLFQ.levels = params->mlfq.levels;
+
+	/* new parameters apply to threads from next aging */
+	mlfq_arm_boost ();
+
+	EXIT ( SUCCESS );
+}
+
+/*! Get global MLFQ parameters */
+static int mlfq_get_sched_parameters ( int sched_policy, sched_t *params )
+{
+	ktime_to_time ( MLFQ.time_slice, &params->mlfq.time_slice );
+	ktime_to_time ( MLFQ.boost_period, &params->mlfq.boost_period );
+	params->mlfq.levels = MLFQ.levels;
+	params->mlfq.level = 0;
+
+	return 0;
+}
+
+/*! Get thread MLFQ parameters (its current level and quantum) */
+static int mlfq_get_thread_sched_parameters ( kthread_t *kthread,
+					      sched_t *params )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	ktime_to_time ( mlfq_quantum ( tsched->params.mlfq.level ),
+			&params->mlfq.time_slice );
+	ktime_to_time ( MLFQ.boost_period, &params->mlfq.boost_period );
+	params->mlfq.levels = MLFQ.levels;
+	params->mlfq.level = tsched->params.mlfq.level;
+
+	return 0;
+}
+
+/*! Requested priority defines thread highest level; level is kept */
+static int mlfq_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.mlfq.prio = prio;
+
+	mlfq_set_level ( kthread, tsched->params.mlfq.level );
+
+	return 0;
+}
+
+/*! Start (or continue) thread quantum */
+static int mlfq_thread_activate ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.mlfq.slice_start = k_get_ktime ();
+
+	k_sched_timer_set ( tsched->params.mlfq.slice_start +
+			    tsched->params.mlfq.remainder,
+			    mlfq_timer, kthread );
+
+	return 0;
+}
+
+/*!
+ * Thread stopped being active:
+ * 1. it is preempted - it keeps rest of its quantum
+ * 2. it is blocked - if it used less than half of its quantum it is promoted;
+ *    anyway it gets full quantum (of its level) when activated again
+ */
+static int mlfq_thread_deactivate ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	int level = tsched->params.mlfq.level;
+	ktime_t used;
+
+	used = k_get_ktime () - tsched->params.mlfq.slice_start;
+
+	if ( kthread_is_ready ( kthread ) )
+	{
+		if ( used < tsched->params.mlfq.remainder )
+			tsched->params.mlfq.remainder -= used;
+		else
+			tsched->params.mlfq.remainder = 0;
+
+		/* preempted thread (not yet put in ready queue) continues
+		   before others on its level */
+		if ( !kthread_get_queue ( kthread ) &&
+		     tsched->params.mlfq.remainder > 0 )
+			kthread_move_to_ready ( kthread, FIRST );
+	}
+	else {
+		/* half of quantum */
+		if ( level > 0 && used < ( mlfq_quantum ( level ) >> 1 ) )
+			level--;
+
+		tsched->params.mlfq.remainder = mlfq_quantum ( level );
+
+		if ( level != tsched->params.mlfq.level )
+			mlfq_set_level ( kthread, level );
+	}
+
+	return 0;
+}
+
+/*! Quantum of active MLFQ thread expired - demote thread */
+static void mlfq_timer ( void *p )
+{
+	kthread_t *kthread = p;
+	kthread_sched_data_t *tsched;
+	int level;
+
+	if ( kthread_get_active () != kthread )
+		return; /* thread already deactivated (blocked or preempted) */
+
+	tsched = kthread_get_sched_param ( kthread );
+
+	level = tsched->params.mlfq.level;
+	if ( level < MLFQ.levels - 1 && tsched->params.mlfq.prio - level > 1 )
+		level++;
+
+	/* new quantum starts now (deactivation will not shorten it) */
+	tsched->params.mlfq.remainder = mlfq_quantum ( level );
+	tsched->params.mlfq.slice_start = k_get_ktime ();
+
+	if ( level != tsched->params.mlfq.level )
+	{
+		mlfq_set_level ( kthread, level ); /* also reschedules */
+	}
+	else {
+		kthread_move_to_ready ( kthread, LAST );
+		kthreads_schedule ();
+	}
+}
+
+/*! Aging: return all MLFQ threads to their highest levels */
+static void mlfq_boost_timer ( void *p )
+{
+	kthread_sched_data_t *tsched;
+	kthread_t *kthread, *next;
+
+	kthread = list_get ( &MLFQ.threads, FIRST );
+	while ( kthread )
+	{
+		tsched = kthread_get_sched_param ( kthread );
+		next = list_get_next ( &tsched->params.mlfq.list );
+
+		if ( tsched->params.mlfq.level > 0 )
+		{
+			tsched->params.mlfq.remainder = mlfq_quantum ( 0 );
+			tsched->params.mlfq.slice_start = k_get_ktime ();
+
+			mlfq_set_level ( kthread, 0 );
+		}
+
+		kthread = next;
+	}
+}
+
+/*! Move thread to given level (set its priority) */
+static void mlfq_set_level ( kthread_t *kthread, int level )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	int prio;
+
+	tsched->params.mlfq.level = level;
+
+	prio = tsched->params.mlfq.prio - level;
+	if ( prio < 1 )
+		prio = 1; /* 0 is for idle thread */
+
+	kthread_set_prio ( kthread, prio );
+}
+
+/*! Calculate quantum for given level: time_slice * 2^level */
+static ktime_t mlfq_quantum ( int level )
+{
+	ktime_t quantum = MLFQ.time_slice;
+
+	for ( ; level > 0 && quantum < 1000 * KTIME_SEC; level-- )
+		quantum += quantum;
+
+	return quantum;
+}
+
+/*! (Re)arm aging alarm if there are MLFQ threads, otherwise disarm it */
+static void mlfq_arm_boost ()
+{
+	MLFQ.boost.exp_time.sec = MLFQ.boost.exp_time.nsec = 0;
+	ktime_to_time ( MLFQ.boost_period, &MLFQ.boost.period );
+
+	if ( list_get ( &MLFQ.threads, FIRST ) && MLFQ.boost_period > 0 )
+		ktime_to_time ( k_get_ktime () + MLFQ.boost_period,
+				&MLFQ.boost.exp_time );
+
+	k_alarm_set ( MLFQ.boost_alarm, &MLFQ.boost );
+}
@@ -0,0 +1,42 @@
+/*! Multi-level feedback queue scheduler */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/list.h>
+#include <lib/ktime.h>
+
+/*! Per thread scheduler data (times are converted only on syscalls) */
+typedef struct _ksched_mlfq_thread_params_
+{
+	int prio;		/* requested priority (highest level) */
+	int level;		/* current level; thread priority is
+				   'prio - level' */
+
+	ktime_t remainder;	/* unused part of current level quantum */
+	ktime_t slice_start;	/* when thread was last activated */
+
+	list_h list;		/* element of list of all MLFQ threads */
+}
+ksched_mlfq_thread_params;
+
+/*! MLFQ global parameters */
+typedef struct _ksched_mlfq_t_
+{
+	int levels;		/* how many levels thread can be demoted through
+				   (including the highest one) */
+	ktime_t time_slice;	/* quantum on highest level; each lower level
+				   has twice longer quantum */
+	ktime_t boost_period;	/* how often are all threads returned to their
+				   highest level (aging); zero to disable */
+
+	list_t threads;		/* all MLFQ threads */
+
+	void *boost_alarm;	/* kernel alarm for aging */
+	alarm_t boost;		/* aging alarm parameters */
+}
+ksched_mlfq_t;
+
+#endif /* _KERNEL_ */
@@ -18,6 +18,10 @@ static int rr_thread_activate ( kthread_t *kthread );
 static void rr_timer ( void *p );
 static int rr_thread_deactivate ( kthread_t *kthread );
 
+static void rr_thread_slice ( kthread_t *kthread, ktime_t *time_slice,
+			      ktime_t *threshold );
+static int rr_time_valid ( time_t *t );
+
 /*! staticaly defined Round Robin Scheduler */
 ksched_t ksched_rr = (ksched_t)
 {
@@ -34,26 +38,24 @@ ksched_t ksched_rr = (ksched_t)
 	.set_thread_sched_parameters =	rr_set_thread_sched_parameters,
 	.get_thread_sched_parameters =	rr_get_thread_sched_parameters,
 
-	.params.rr.time_slice =	{ 0, 50000000 },
-	.params.rr.threshold =	{ 0, 10000000 }
+	.params.rr.time_slice =	50000000,
+	.params.rr.threshold =	10000000,
+	.params.rr.defer =	2000000
 };
 
 /*! Init RR scheduler */
 static int rr_init ( ksched_t *self )
 {
-	*self = ksched_rr;
+	int i;
 
-	/* reserve an empty alarm */
-	self->params.rr.alarm.exp_time.sec = 0;
-	self->params.rr.alarm.exp_time.nsec = 0;
-	self->params.rr.alarm.period.sec = 0;
-	self->params.rr.alarm.period.nsec = 0;
-	self->params.rr.alarm.action = rr_timer;
-	self->params.rr.alarm.param = NULL;
-	self->params.rr.alarm.flags = 0;
+	*self = ksched_rr;
 
-	k_alarm_new ( &self->params.rr.rr_alarm, &self->params.rr.alarm,
-		      KERNELCALL );
+	/* all priorities start with same defaults */
+	for ( i = 0; i < PRIO_LEVELS; i++ )
+	{
+		self->params.rr.prio_slice[i] = self->params.rr.time_slice;
+		self->params.rr.prio_threshold[i] = self->params.rr.threshold;
+	}
 
 	return 0;
 }
@@ -62,9 +64,13 @@ static int rr_init ( ksched_t *self )
 static int rr_thread_add ( kthread_t *kthread )
 {
 	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
-	ksched_t *gsched = ksched_get ( tsched->sched_policy );
+	ktime_t threshold;
+
+	/* use defaults for thread priority until parameters are set */
+	tsched->params.rr.time_slice = tsched->params.rr.threshold = 0;
 
-	tsched->params.rr.remainder = gsched->params.rr.time_slice;
+	rr_thread_slice ( kthread, &tsched->params.rr.remainder, &threshold );
+	tsched->params.rr.deferred = FALSE;
 
 	return 0;
 }
@@ -74,60 +80,128 @@ static int rr_thread_remove ( kthread_t *thread )
 	return 0;
 }
 
+/*!
+ * Set defaults for threads with priority 'params->rr.prio' or, when it is
+ * zero, for threads of all priorities
+ */
 static int rr_set_sched_parameters ( int sched_policy, sched_t *params )
 {
 	ksched_t *gsched = ksched_get ( sched_policy );
+	int i, prio = params->rr.prio;
+	ktime_t time_slice, threshold;
 
-	gsched->params.rr.time_slice = params->rr.time_slice;
+	if ( prio < 0 || prio >= PRIO_LEVELS ||
+	     !rr_time_valid ( &params->rr.time_slice ) ||
+	     !rr_time_valid ( &params->rr.threshold ) ||
+	     !( params->rr.time_slice.sec + params->rr.time_slice.nsec ) )
+		EXIT ( E_INVALID_ARGUMENT );
 
-	return 0;
+	time_slice = time_to_ktime ( &params->rr.time_slice );
+	threshold = time_to_ktime ( &params->rr.threshold );
+
+	if ( prio )
+	{
+		gsched->params.rr.prio_slice[prio] = time_slice;
+		gsched->params.rr.prio_threshold[prio] = threshold;
+	}
+	else {
+		gsched->params.rr.time_slice = time_slice;
+		gsched->params.rr.threshold = threshold;
+
+		for ( i = 0; i < PRIO_LEVELS; i++ )
+		{
+			gsched->params.rr.prio_slice[i] = time_slice;
+			gsched->params.rr.prio_threshold[i] = threshold;
+		}
+	}
+
+	EXIT ( SUCCESS );
 }
+
+/*! Get defaults for threads with priority 'params->rr.prio' (or global) */
 static int rr_get_sched_parameters ( int sched_policy, sched_t *params )
 {
-	/* TODO */
-	return 0;
+	ksched_t *gsched = ksched_get ( sched_policy );
+	int prio = params->rr.prio;
+
+	if ( prio < 0 || prio >= PRIO_LEVELS )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	if ( prio )
+	{
+		ktime_to_time ( gsched->params.rr.prio_slice[prio],
+				&params->rr.time_slice );
+		ktime_to_time ( gsched->params.rr.prio_threshold[prio],
+				&params->rr.threshold );
+	}
+	else {
+		ktime_to_time ( gsched->params.rr.time_slice,
+				&params->rr.time_slice );
+		ktime_to_time ( gsched->params.rr.threshold,
+				&params->rr.threshold );
+	}
+
+	EXIT ( SUCCESS );
 }
 
+/*! Set thread own time slice and threshold (zero - use priority defaults) */
 static int rr_set_thread_sched_parameters ( kthread_t *kthread, sched_t *params )
 {
-	/* Nothing to set for thread! Just as an example - set to global RR */
-	ksched_rr.params.rr.time_slice = params->rr.time_slice;
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	ktime_t time_slice, threshold;
 
-	return 0;
+	if ( !rr_time_valid ( &params->rr.time_slice ) ||
+	     !rr_time_valid ( &params->rr.threshold ) )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	tsched->params.rr.time_slice = time_to_ktime ( &params->rr.time_slice );
+	tsched->params.rr.threshold = time_to_ktime ( &params->rr.threshold );
+
+	/* remaining part of current slice can't be longer than new slice */
+	rr_thread_slice ( kthread, &time_slice, &threshold );
+	if ( tsched->params.rr.remainder > time_slice )
+		tsched->params.rr.remainder = time_slice;
+
+	EXIT ( SUCCESS );
 }
 
+/*! Get thread time slice and threshold (currently used ones) */
 static int rr_get_thread_sched_parameters ( kthread_t *kthread, sched_t *params )
 {
-	/* TODO */
-	return 0;
+	ktime_t time_slice, threshold;
+
+	rr_thread_slice ( kthread, &time_slice, &threshold );
+	ktime_to_time ( time_slice, &params->rr.time_slice );
+	ktime_to_time ( threshold, &params->rr.threshold );
+	params->rr.prio = kthread_get_prio ( kthread );
+
+	EXIT ( SUCCESS );
 }
 
 /*! Start time slice for thread (or countinue interrupted) */
 static int rr_thread_activate ( kthread_t *kthread )
 {
 	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
-	ksched_t *gsched = ksched_get ( tsched->sched_policy );
+	ktime_t time_slice, threshold;
+
+	rr_thread_slice ( kthread, &time_slice, &threshold );
 
 	/* check remainder if needs to be replenished */
-	if ( time_cmp ( &tsched->params.rr.remainder,
-		&gsched->params.rr.threshold ) <= 0 )
+	if ( tsched->params.rr.remainder <= threshold )
 	{
-		time_add ( &tsched->params.rr.remainder,
-			   &gsched->params.rr.time_slice );
+		tsched->params.rr.remainder += time_slice;
+		tsched->params.rr.deferred = FALSE;
 	}
 
 	/* Get current time and store it */
-	k_get_time ( &tsched->params.rr.slice_start );
+	tsched->params.rr.slice_start = k_get_ktime ();
 
 	/* When to wake up? */
-	tsched->params.rr.slice_end = tsched->params.rr.slice_start;
-	time_add ( &tsched->params.rr.slice_end, &tsched->params.rr.remainder );
-
-	/* Set alarm for remainder time */
-	gsched->params.rr.alarm.exp_time = tsched->params.rr.slice_end;
-	gsched->params.rr.alarm.param = kthread;
+	tsched->params.rr.slice_end = tsched->params.rr.slice_start +
+				      tsched->params.rr.remainder;
 
-	k_alarm_set ( gsched->params.rr.rr_alarm, &gsched->params.rr.alarm );
+	/* Set scheduler timer for remainder time */
+	k_sched_timer_set ( tsched->params.rr.slice_end, rr_timer, kthread );
 
 	return 0;
 }
@@ -137,6 +211,7 @@ static void rr_timer ( void *p )
 {
 	kthread_t *kthread = p;
 	kthread_sched_data_t *tsched;
+	volatile int *hint;
 
 	if ( kthread_get_active () != kthread )
 	{
@@ -146,8 +221,27 @@ static void rr_timer ( void *p )
 
 	tsched = kthread_get_sched_param ( kthread );
 
+	/*
+	 * thread is in critical section (e.g. holds spin lock): preempting it
+	 * now would make others spin on its lock for whole slice, so give it
+	 * short extension (once per slice) and ask it to yield when done
+	 */
+	hint = kthread_get_preempt_hint ( kthread );
+	if ( hint && ( *hint & PREEMPT_DEFER ) && !tsched->params.rr.deferred )
+	{
+		tsched->params.rr.deferred = TRUE;
+		*hint |= PREEMPT_YIELD;
+
+		tsched->params.rr.slice_end = k_get_ktime () +
+					      ksched_rr.params.rr.defer;
+		k_sched_timer_set ( tsched->params.rr.slice_end, rr_timer,
+				    kthread );
+
+		return;
+	}
+
 	/* given time is elapsed, set remainder to zero */
-	tsched->params.rr.remainder.sec = tsched->params.rr.remainder.nsec = 0;
+	tsched->params.rr.remainder = 0;
 
 	/* move thread to ready queue - as last in coresponding queue */
 	kthread_move_to_ready ( kthread, LAST );
@@ -164,25 +258,28 @@ static void rr_timer ( void *p )
 static int rr_thread_deactivate ( kthread_t *kthread )
 {
 	/* Get current time and recalculate remainder */
-	time_t t;
 	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
-	ksched_t *gsched = ksched_get ( tsched->sched_policy );
+	ktime_t time_slice, threshold;
 
-	if (tsched->params.rr.remainder.sec + tsched->params.rr.remainder.nsec)
+	if ( tsched->params.rr.remainder )
 	{
 		/*
 		 * "slice interrupted"
 		 * recalculate remainder
 		 */
-		k_get_time ( &t );
-		time_sub ( &tsched->params.rr.slice_end, &t );
-		tsched->params.rr.remainder = tsched->params.rr.slice_end;
-
-		if ( kthread_is_ready ( kthread ) )
+		tsched->params.rr.remainder = tsched->params.rr.slice_end -
+					      k_get_ktime ();
+		if ( tsched->params.rr.remainder < 0 )
+			tsched->params.rr.remainder = 0;
+
+		/* (unless already put in some ready queue) */
+		if ( kthread_is_ready ( kthread ) &&
+		     !kthread_get_queue ( kthread ) )
 		{
+			rr_thread_slice ( kthread, &time_slice, &threshold );
+
 			/* is remainder too small or not? */
-			if ( time_cmp ( &tsched->params.rr.remainder,
-				&gsched->params.rr.threshold ) <= 0 )
+			if ( tsched->params.rr.remainder <= threshold )
 			{
 				kthread_move_to_ready ( kthread, LAST );
 			}
@@ -196,3 +293,26 @@ static int rr_thread_deactivate ( kthread_t *kthread )
 	return 0;
 }
 
+/*! Get thread time slice and threshold (own or its priority defaults) */
+static void rr_thread_slice ( kthread_t *kthread, ktime_t *time_slice,
+			      ktime_t *threshold )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	int prio = kthread_get_prio ( kthread );
+
+	if ( tsched->params.rr.time_slice )
+		*time_slice = tsched->params.rr.time_slice;
+	else
+		*time_slice = ksched_rr.params.rr.prio_slice[prio];
+
+	if ( tsched->params.rr.threshold )
+		*threshold = tsched->params.rr.threshold;
+	else
+		*threshold = ksched_rr.params.rr.prio_threshold[prio];
+}
+
+/*! Is given time valid (non negative) slice or threshold */
+static int rr_time_valid ( time_t *t )
+{
+	return t->sec >= 0 && t->nsec >= 0 && t->nsec < 1000000000;
+}
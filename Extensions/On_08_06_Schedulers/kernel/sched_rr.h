@@ -5,25 +5,36 @@
 #ifdef _KERNEL_
 
 #include <lib/types.h>
+#include <lib/ktime.h>
 
-/*! Per thread scheduler data */
+/*! Per thread scheduler data (times are converted only on syscalls) */
 typedef struct _ksched_rr_thread_params_
 {
-	time_t slice_start;
-	time_t slice_end;
-	time_t remainder;
+	ktime_t time_slice;	/* thread time slice and threshold; when zero */
+	ktime_t threshold;	/* defaults for thread priority are used */
+
+	ktime_t slice_start;
+	ktime_t slice_end;
+	ktime_t remainder;
+
+	int deferred;		/* extension (preemption deferral) is given in
+				   current slice */
 }
 ksched_rr_thread_params;
 
 /*! Round Robin global parameters */
 typedef struct _ksched_rr_t_
 {
-	time_t time_slice;	/* time slice each thread is given at start */
-	time_t threshold;	/* if remaining time is less than threshold
+	ktime_t time_slice;	/* time slice each thread is given at start */
+	ktime_t threshold;	/* if remaining time is less than threshold
 				   do not return to that thread, but schedule
 				   next one */
-	void *rr_alarm;		/* kernel alarm reference used in RR */
-	alarm_t alarm;		/* alarm parameters */
+	ktime_t defer;		/* extension given to thread whose slice
+				   expired while it requested deferral */
+
+	/* defaults for threads (without own parameters) per priority */
+	ktime_t prio_slice[PRIO_LEVELS];
+	ktime_t prio_threshold[PRIO_LEVELS];
 }
 ksched_rr_t;
 
@@ -0,0 +1,287 @@
+/*! Bandwidth server Scheduler */
+#define _KERNEL_
+
+/*!
+ * Aperiodic threads (signal handlers and alarm actions are created as such)
+ * are served by single server with budget 'budget' which is replenished
+ * every 'period'. Server threads run with their own priorities while server
+ * has budget; processor time they use is subtracted from budget. When budget
+ * is exhausted, all server threads are moved to 'prio_low' until next
+ * replenishment, so they can't interfere with (periodic) real-time threads
+ * for more than 'budget' in each 'period'.
+ */
+
+#include "sched_server.h"
+#include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int server_init ( ksched_t *self );
+static int server_thread_add ( kthread_t *kthread );
+static int server_thread_remove ( kthread_t *kthread );
+static int server_set_sched_parameters ( int sched_policy, sched_t *params );
+static int server_get_sched_parameters ( int sched_policy, sched_t *params );
+static int server_set_thread_prio ( kthread_t *kthread, int prio );
+static int server_thread_activate ( kthread_t *kthread );
+static int server_thread_deactivate ( kthread_t *kthread );
+
+static void server_budget_timer ( void *p );
+static void server_replenish_timer ( void *p );
+
+static void server_set_priorities ();
+static void server_arm_replenish ();
+
+/*! staticaly defined bandwidth server Scheduler */
+ksched_t ksched_server = (ksched_t)
+{
+	.sched_id =		SCHED_SERVER,
+
+	.init = 		server_init,
+	.thread_add =		server_thread_add,
+	.thread_remove =	server_thread_remove,
+	.thread_activate =	server_thread_activate,
+	.thread_deactivate =	server_thread_deactivate,
+
+	.set_sched_parameters =		server_set_sched_parameters,
+	.get_sched_parameters =		server_get_sched_parameters,
+	.set_thread_sched_parameters =	NULL,
+	.get_thread_sched_parameters =	NULL,
+	.set_thread_prio =		server_set_thread_prio,
+
+	.params.server.budget =		20000000,
+	.params.server.period =		100000000,
+	.params.server.prio_low =	1
+};
+
+#define SERVER	ksched_server.params.server
+
+/*! Init server scheduler */
+static int server_init ( ksched_t *self )
+{
+	list_init ( &self->params.server.threads );
+
+	self->params.server.remaining = self->params.server.budget;
+	self->params.server.exhausted = FALSE;
+
+	/* reserve an empty alarm (armed when first thread is added) */
+	self->params.server.replenish.exp_time.sec = 0;
+	self->params.server.replenish.exp_time.nsec = 0;
+	ktime_to_time ( self->params.server.period,
+			&self->params.server.replenish.period );
+	self->params.server.replenish.action = server_replenish_timer;
+	self->params.server.replenish.param = NULL;
+	self->params.server.replenish.flags = ALARM_PERIODIC;
+
+	k_alarm_new ( &self->params.server.replenish_alarm,
+		      &self->params.server.replenish, KERNELCALL );
+
+	return 0;
+}
+
+/*! Add thread to server; it keeps its priority while server has budget */
+static int server_thread_add ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.server.prio = kthread_get_prio ( kthread );
+
+	list_append ( &SERVER.threads, kthread, &tsched->params.server.list );
+
+	/* first thread starts with full budget */
+	if ( list_get ( &SERVER.threads, FIRST ) == kthread )
+	{
+		SERVER.remaining = SERVER.budget;
+		SERVER.exhausted = FALSE;
+		server_arm_replenish ();
+	}
+	else if ( SERVER.exhausted )
+	{
+		kthread_set_prio ( kthread, SERVER.prio_low );
+	}
+
+	return 0;
+}
+
+/*!
+ * Remove thread from server; thread keeps its current priority until new
+ * priority is set
+ */
+static int server_thread_remove ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	if ( kthread == kthread_get_active () )
+		server_thread_deactivate ( kthread );
+
+	list_remove ( &SERVER.threads, FIRST, &tsched->params.server.list );
+
+	if ( !list_get ( &SERVER.threads, FIRST ) )
+		server_arm_replenish ();
+
+	return 0;
+}
+
+/*! Set server budget, period and background priority */
+static int server_set_sched_parameters ( int sched_policy, sched_t *params )
+{
+	if ( params->server.budget.sec < 0 || params->server.budget.nsec < 0 ||
+	     params->server.period.sec < 0 ||
+	     ( !params->server.period.sec &&
+	       params->server.period.nsec <= 0 ) ||
+	     time_cmp ( &params->server.budget, &params->server.period ) > 0 ||
+	     params->server.prio_low < 1 ||
+	     params->server.prio_low >= PRIO_LEVELS )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	SERVER.budget = time_to_ktime ( &params->server.budget );
+	SERVER.period = time_to_ktime ( &params->server.period );
+	SERVER.prio_low = params->server.prio_low;
+
+	/* start new period with full budget */
+	SERVER.remaining = SERVER.budget;
+	SERVER.exhausted = FALSE;
+	server_set_priorities ();
+	server_arm_replenish ();
+
+	EXIT ( SUCCESS );
+}
+
+/*! Get server parameters */
+static int server_get_sched_parameters ( int sched_policy, sched_t *params )
+{
+	ktime_to_time ( SERVER.budget, &params->server.budget );
+	ktime_to_time ( SERVER.period, &params->server.period );
+	params->server.prio_low = SERVER.prio_low;
+	ktime_to_time ( SERVER.remaining, &params->server.remaining );
+
+	return 0;
+}
+
+/*! Requested priority is used while server has budget */
+static int server_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	tsched->params.server.prio = prio;
+
+	if ( !SERVER.exhausted && prio != kthread_get_prio ( kthread ) )
+		kthread_set_prio ( kthread, prio );
+
+	return 0;
+}
+
+/*! Server thread becomes active - start consuming budget */
+static int server_thread_activate ( kthread_t *kthread )
+{
+	SERVER.exec_start = k_get_ktime ();
+
+	if ( SERVER.exhausted || !SERVER.budget )
+		return 0; /* running in background or without limit */
+
+	k_sched_timer_set ( SERVER.exec_start + SERVER.remaining,
+			    server_budget_timer, kthread );
+
+	return 0;
+}
+
+/*! Server thread stopped being active - subtract used time from budget */
+static int server_thread_deactivate ( kthread_t *kthread )
+{
+	ktime_t now, used;
+
+	if ( SERVER.exhausted || !SERVER.budget )
+		return 0;
+
+	now = k_get_ktime ();
+	used = now - SERVER.exec_start;
+	SERVER.exec_start = now;
+
+	if ( used < 0 )
+		return 0;
+
+	if ( used < SERVER.remaining )
+		SERVER.remaining -= used;
+	else
+		SERVER.remaining = 0;
+
+	return 0;
+}
+
+/*! Server budget is exhausted - move server threads to background */
+static void server_budget_timer ( void *p )
+{
+	kthread_t *kthread = p;
+
+	if ( kthread_get_active () != kthread || SERVER.exhausted )
+		return; /* thread already deactivated (blocked or preempted) */
+
+	server_thread_deactivate ( kthread );
+
+	SERVER.remaining = 0;
+	SERVER.exhausted = TRUE;
+
+	server_set_priorities ();
+}
+
+/*! New period - replenish server budget */
+static void server_replenish_timer ( void *p )
+{
+	kthread_t *active = kthread_get_active ();
+
+	/* time used so far is accounted in previous period */
+	if ( kthread_get_sched_param ( active )->sched_policy == SCHED_SERVER )
+		server_thread_deactivate ( active );
+
+	SERVER.remaining = SERVER.budget;
+	SERVER.exec_start = k_get_ktime ();
+
+	if ( SERVER.exhausted )
+	{
+		SERVER.exhausted = FALSE;
+		server_set_priorities ();
+	}
+
+	/* (re)start budget timer for active server thread */
+	active = kthread_get_active ();
+	if ( kthread_get_sched_param ( active )->sched_policy == SCHED_SERVER )
+		server_thread_activate ( active );
+}
+
+/*! Set priorities of all server threads (depending on server budget) */
+static void server_set_priorities ()
+{
+	kthread_sched_data_t *tsched;
+	kthread_t *kthread, *next;
+	int prio;
+
+	kthread = list_get ( &SERVER.threads, FIRST );
+	while ( kthread )
+	{
+		tsched = kthread_get_sched_param ( kthread );
+		next = list_get_next ( &tsched->params.server.list );
+
+		if ( SERVER.exhausted )
+			prio = SERVER.prio_low;
+		else
+			prio = tsched->params.server.prio;
+
+		if ( prio != kthread_get_prio ( kthread ) )
+			kthread_set_prio ( kthread, prio );
+
+		kthread = next;
+	}
+}
+
+/*! (Re)arm replenishment alarm if there are server threads */
+static void server_arm_replenish ()
+{
+	SERVER.replenish.exp_time.sec = SERVER.replenish.exp_time.nsec = 0;
+	ktime_to_time ( SERVER.period, &SERVER.replenish.period );
+
+	if ( list_get ( &SERVER.threads, FIRST ) && SERVER.budget > 0 )
+		ktime_to_time ( k_get_ktime () + SERVER.period,
+				&SERVER.replenish.exp_time );
+
+	k_alarm_set ( SERVER.replenish_alarm, &SERVER.replenish );
+}
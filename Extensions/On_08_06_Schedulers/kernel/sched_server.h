@@ -0,0 +1,39 @@
+/*! Bandwidth server scheduler (for aperiodic threads) */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/list.h>
+#include <lib/ktime.h>
+
+/*! Per thread scheduler data */
+typedef struct _ksched_server_thread_params_
+{
+	int prio;		/* priority thread has while server has budget */
+
+	list_h list;		/* element of list of server threads */
+}
+ksched_server_thread_params;
+
+/*! Server global parameters (times are converted only on syscalls) */
+typedef struct _ksched_server_t_
+{
+	ktime_t budget;		/* processor time server threads may use ... */
+	ktime_t period;		/* ... in each period (zero budget: no limit) */
+	int prio_low;		/* priority of server threads when budget is
+				   exhausted (background) */
+
+	ktime_t remaining;	/* budget remaining in current period */
+	ktime_t exec_start;	/* when server thread was last activated */
+	int exhausted;		/* server threads are in background */
+
+	list_t threads;		/* all server threads */
+
+	void *replenish_alarm;	/* kernel alarm for budget replenishment */
+	alarm_t replenish;	/* replenishment alarm parameters */
+}
+ksched_server_t;
+
+#endif /* _KERNEL_ */
@@ -0,0 +1,401 @@
+/*! Stride Scheduler */
+#define _KERNEL_
+
+/*!
+ * Each stride thread holds tickets; its stride is inversely proportional to
+ * number of tickets. Thread pass is increased by stride for each unit of
+ * processor time thread uses, while thread with smallest pass is selected
+ * (all stride threads are put on single priority level 'prio' whose ready
+ * queue is sorted by pass). Processor is thus shared proportionally to
+ * tickets, regardless of thread priorities.
+ * When process has its own tickets (proc_tickets), they are divided among
+ * its stride threads in proportion to their tickets, so process share does
+ * not depend on number of its threads.
+ * Thread may name a server thread; while blocked on message queue or
+ * semaphore, its tickets are transferred to that server.
+ */
+
+#include "sched_stride.h"
+#include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/errno.h>
+#include <lib/types.h>
+
+static int stride_init ( ksched_t *self );
+static int stride_thread_add ( kthread_t *kthread );
+static int stride_thread_remove ( kthread_t *kthread );
+static int stride_set_sched_parameters ( int sched_policy, sched_t *params );
+static int stride_get_sched_parameters ( int sched_policy, sched_t *params );
+static int stride_set_thread_sched_parameters ( kthread_t *kthread,
+						sched_t *params );
+static int stride_get_thread_sched_parameters ( kthread_t *kthread,
+						sched_t *params );
+static int stride_set_thread_prio ( kthread_t *kthread, int prio );
+static int stride_thread_activate ( kthread_t *kthread );
+static int stride_thread_deactivate ( kthread_t *kthread );
+static int stride_thread_ipc_block ( kthread_t *kthread );
+
+static void stride_timer ( void *p );
+
+static int stride_tickets ( kthread_t *kthread );
+static void stride_update_pass ( kthread_t *kthread );
+static void stride_return_tickets ( kthread_t *kthread );
+static kthread_t *stride_server ( kthread_t *kthread );
+
+static int stride_pass_cmp ( void *a, void *b );
+
+/*! pass increment for one ticket and 1024 ns */
+#define STRIDE1		( 1 << 20 )
+#define STRIDE_SHIFT	10
+
+#define STRIDE_DEFAULT_TICKETS	100
+#define STRIDE_MAX_TICKETS	( 1 << 16 )
+
+/*! staticaly defined Stride Scheduler */
+ksched_t ksched_stride = (ksched_t)
+{
+	.sched_id =		SCHED_STRIDE,
+
+	.init = 		stride_init,
+	.thread_add =		stride_thread_add,
+	.thread_remove =	stride_thread_remove,
+	.thread_activate =	stride_thread_activate,
+	.thread_deactivate =	stride_thread_deactivate,
+
+	.set_sched_parameters =		stride_set_sched_parameters,
+	.get_sched_parameters =		stride_get_sched_parameters,
+	.set_thread_sched_parameters =	stride_set_thread_sched_parameters,
+	.get_thread_sched_parameters =	stride_get_thread_sched_parameters,
+	.set_thread_prio =		stride_set_thread_prio,
+	.thread_ipc_block =		stride_thread_ipc_block,
+
+	.params.stride.prio =		THR_DEFAULT_PRIO - 3,
+	.params.stride.time_slice =	10000000
+};
+
+#define STRIDE	ksched_stride.params.stride
+
+/*! Init stride scheduler */
+static int stride_init ( ksched_t *self )
+{
+	self->params.stride.min_pass = 0;
+
+	/* threads on stride priority level are ordered by pass */
+	kthread_ready_list_sort ( self->params.stride.prio, stride_pass_cmp );
+
+	return 0;
+}
+
+/*!
+ * Add thread to stride scheduler with default number of tickets; thread is
+ * moved to stride priority level and starts with smallest pass
+ */
+static int stride_thread_add ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kprocess_t *proc = kthread_get_process ( kthread );
+
+	tsched->params.stride.tickets = STRIDE_DEFAULT_TICKETS;
+	tsched->params.stride.received = 0;
+	tsched->params.stride.server = NULL;
+	tsched->params.stride.transferred = 0;
+
+	proc->stride_thr_tickets += tsched->params.stride.tickets;
+
+	tsched->vruntime = STRIDE.min_pass;
+	tsched->params.stride.exec_start = k_get_ktime ();
+
+	if ( kthread_get_prio ( kthread ) != STRIDE.prio )
+		kthread_set_prio ( kthread, STRIDE.prio );
+
+	return 0;
+}
+
+/*!
+ * Remove thread from stride scheduler; thread stays on stride priority level
+ * until new priority is set
+ */
+static int stride_thread_remove ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kprocess_t *proc = kthread_get_process ( kthread );
+
+	if ( kthread == kthread_get_active () )
+		stride_update_pass ( kthread );
+
+	stride_return_tickets ( kthread );
+
+	proc->stride_thr_tickets -= tsched->params.stride.tickets;
+
+	return 0;
+}
+
+/*! Set global stride parameters */
+static int stride_set_sched_parameters ( int sched_policy, sched_t *params )
+{
+	if ( params->stride.time_slice.sec < 0 ||
+	     ( !params->stride.time_slice.sec &&
+	       params->stride.time_slice.nsec <= 0 ) )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	STRIDE.time_slice = time_to_ktime ( &params->stride.time_slice );
+
+	EXIT ( SUCCESS );
+}
+
+/*! Get global stride parameters */
+static int stride_get_sched_parameters ( int sched_policy, sched_t *params )
+{
+	ktime_to_time ( STRIDE.time_slice, &params->stride.time_slice );
+	params->stride.tickets = STRIDE_DEFAULT_TICKETS;
+	params->stride.proc_tickets = 0;
+	params->stride.server.thread = NULL;
+	params->stride.flags = 0;
+
+	return 0;
+}
+
+/*! Set thread tickets, its process tickets and/or its server */
+static int stride_set_thread_sched_parameters ( kthread_t *kthread,
+						sched_t *params )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kprocess_t *proc = kthread_get_process ( kthread );
+	kthread_t *server = params->stride.server.thread;
+
+	if ( params->stride.tickets < 0 ||
+	     params->stride.tickets > STRIDE_MAX_TICKETS ||
+	     params->stride.proc_tickets < 0 ||
+	     params->stride.proc_tickets > STRIDE_MAX_TICKETS )
+		EXIT ( E_INVALID_ARGUMENT );
+
+	if ( ( params->stride.flags & STRIDE_SERVER ) && server &&
+	     ( params->stride.server.thr_id != kthread_get_id ( server ) ||
+	       server == kthread ) )
+		EXIT ( E_INVALID_HANDLE );
+
+	/* time consumed so far is accounted with previous tickets */
+	if ( kthread == kthread_get_active () )
+		stride_update_pass ( kthread );
+
+	if ( params->stride.tickets > 0 )
+	{
+		proc->stride_thr_tickets += params->stride.tickets -
+					    tsched->params.stride.tickets;
+		tsched->params.stride.tickets = params->stride.tickets;
+	}
+
+	if ( params->stride.proc_tickets > 0 )
+		proc->stride_tickets = params->stride.proc_tickets;
+
+	if ( params->stride.flags & STRIDE_SERVER )
+	{
+		tsched->params.stride.server = server;
+		tsched->params.stride.server_id = params->stride.server.thr_id;
+	}
+
+	EXIT ( SUCCESS );
+}
+
+/*! Get thread stride parameters */
+static int stride_get_thread_sched_parameters ( kthread_t *kthread,
+						sched_t *params )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kprocess_t *proc = kthread_get_process ( kthread );
+
+	ktime_to_time ( STRIDE.time_slice, &params->stride.time_slice );
+	params->stride.tickets = tsched->params.stride.tickets;
+	params->stride.proc_tickets = proc->stride_tickets;
+	params->stride.server.thread = tsched->params.stride.server;
+	params->stride.server.thr_id = tsched->params.stride.server_id;
+	params->stride.flags = 0;
+
+	return 0;
+}
+
+/*! Requested priority is ignored, thread stays on stride priority level */
+static int stride_set_thread_prio ( kthread_t *kthread, int prio )
+{
+	return 0;
+}
+
+/*! Thread is selected by primary scheduler (had smallest pass) */
+static int stride_thread_activate ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+
+	/* thread returned from IPC - take back tickets given to server */
+	stride_return_tickets ( kthread );
+
+	/* thread which was blocked doesn't keep advantage from that time */
+	if ( tsched->vruntime < STRIDE.min_pass )
+		tsched->vruntime = STRIDE.min_pass;
+	else
+		STRIDE.min_pass = tsched->vruntime;
+
+	tsched->params.stride.exec_start = k_get_ktime ();
+
+	/* let other threads check for smaller pass after 'time_slice' */
+	k_sched_timer_set ( tsched->params.stride.exec_start +
+			    STRIDE.time_slice, stride_timer, kthread );
+
+	return 0;
+}
+
+/*! Thread stopped being active - advance its pass */
+static int stride_thread_deactivate ( kthread_t *kthread )
+{
+	kthread_q *q = kthread_get_queue ( kthread );
+
+	if ( kthread_is_ready ( kthread ) && q &&
+	     ( q->flags & KTHREADQ_SORTED ) )
+	{
+		/* already put in ready queue (e.g. on yield); it is sorted by
+		   pass, so thread is re-inserted with new one */
+		kthread_remove_from_ready ( kthread );
+		stride_update_pass ( kthread );
+		kthread_move_to_ready ( kthread, LAST );
+	}
+	else {
+		stride_update_pass ( kthread );
+	}
+
+	return 0;
+}
+
+/*! Thread blocks on message queue or semaphore - transfer tickets */
+static int stride_thread_ipc_block ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kthread_t *server = stride_server ( kthread );
+	kthread_sched_data_t *ssched;
+	int tickets;
+
+	if ( !server || tsched->params.stride.transferred )
+		return 0;
+
+	ssched = kthread_get_sched_param ( server );
+
+	/* time server consumed so far is accounted with previous tickets */
+	if ( server == kthread_get_active () )
+		stride_update_pass ( server );
+
+	tickets = stride_tickets ( kthread );
+	tsched->params.stride.transferred = tickets;
+	ssched->params.stride.received += tickets;
+
+	return 0;
+}
+
+/*! Time slice of active stride thread expired */
+static void stride_timer ( void *p )
+{
+	kthread_t *kthread = p;
+
+	if ( kthread_get_active () != kthread )
+		return; /* thread already deactivated (blocked or preempted) */
+
+	/* update before moving, ready queue is sorted by pass */
+	stride_update_pass ( kthread );
+
+	kthread_move_to_ready ( kthread, LAST );
+
+	kthreads_schedule ();
+}
+
+/*! Get thread effective tickets (own, share of process and received ones) */
+static int stride_tickets ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kprocess_t *proc = kthread_get_process ( kthread );
+	int tickets = tsched->params.stride.tickets;
+
+	if ( proc->stride_tickets > 0 && proc->stride_thr_tickets > 0 )
+	{
+		tickets = proc->stride_tickets * tickets /
+			  proc->stride_thr_tickets;
+		if ( tickets < 1 )
+			tickets = 1;
+	}
+
+	tickets += tsched->params.stride.received;
+
+	if ( tickets > STRIDE_MAX_TICKETS )
+		tickets = STRIDE_MAX_TICKETS;
+
+	return tickets;
+}
+
+/*! Add time elapsed from 'exec_start' (times stride) to thread pass */
+static void stride_update_pass ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	ktime_t now, delta;
+
+	now = k_get_ktime ();
+
+	delta = now - tsched->params.stride.exec_start;
+	tsched->params.stride.exec_start = now;
+
+	if ( delta < 0 )
+		return;
+
+	tsched->vruntime += ( (uint64) delta * ( STRIDE1 / stride_tickets ( kthread ) ) )
+			    >> STRIDE_SHIFT;
+}
+
+/*! Take back tickets thread transferred to its server (if any) */
+static void stride_return_tickets ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kthread_t *server;
+	kthread_sched_data_t *ssched;
+
+	if ( !tsched->params.stride.transferred )
+		return;
+
+	server = stride_server ( kthread );
+	if ( server )
+	{
+		ssched = kthread_get_sched_param ( server );
+
+		if ( server == kthread_get_active () )
+			stride_update_pass ( server );
+
+		ssched->params.stride.received -=
+					tsched->params.stride.transferred;
+		if ( ssched->params.stride.received < 0 )
+			ssched->params.stride.received = 0;
+	}
+
+	tsched->params.stride.transferred = 0;
+}
+
+/*! Get thread server if it still exists and is stride thread */
+static kthread_t *stride_server ( kthread_t *kthread )
+{
+	kthread_sched_data_t *tsched = kthread_get_sched_param ( kthread );
+	kthread_t *server = tsched->params.stride.server;
+
+	if ( !server || kthread_get_id ( server ) !=
+					tsched->params.stride.server_id ||
+	     kthread_get_sched_param ( server )->sched_policy != SCHED_STRIDE )
+		return NULL;
+
+	return server;
+}
+
+/*! Compare threads by pass (ready queue order) */
+static int stride_pass_cmp ( void *a, void *b )
+{
+	uint64 pa = kthread_get_sched_param ( a )->vruntime;
+	uint64 pb = kthread_get_sched_param ( b )->vruntime;
+
+	if ( pa < pb )
+		return -1;
+	else if ( pa > pb )
+		return 1;
+	else
+		return 0;
+}
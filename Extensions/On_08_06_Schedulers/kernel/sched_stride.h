@@ -0,0 +1,38 @@
+/*! Stride (proportional share) scheduler */
+
+#pragma once
+
+#ifdef _KERNEL_
+
+#include <lib/types.h>
+#include <lib/ktime.h>
+
+/*! Per thread scheduler data (pass is kept in kthread_sched_data_t) */
+typedef struct _ksched_stride_thread_params_
+{
+	int tickets;		/* thread own tickets */
+	int received;		/* tickets transferred from blocked clients */
+
+	void *server;		/* thread which receives tickets while this
+				   thread is blocked on IPC (or NULL) */
+	int server_id;		/* its id (to detect if it no longer exists) */
+	int transferred;	/* tickets currently given to server */
+
+	ktime_t exec_start;	/* when thread was last activated (or its
+				   pass last updated) */
+}
+ksched_stride_thread_params;
+
+/*! Stride global parameters */
+typedef struct _ksched_stride_t_
+{
+	int prio;		/* priority level (ready queue) of stride
+				   threads */
+	ktime_t time_slice;	/* longest run before preemption by thread with
+				   smaller pass */
+
+	uint64 min_pass;	/* (monotonic) smallest pass */
+}
+ksched_stride_t;
+
+#endif /* _KERNEL_ */
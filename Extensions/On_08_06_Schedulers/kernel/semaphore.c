@@ -27,7 +27,7 @@ int sys__sem_init ( void *p )
 	ASSERT ( ksem );
 
 	ksem->sem_value = initial_value;
-	kthreadq_init ( &ksem->queue );
+	kthreadq_init_prio ( &ksem->queue );
 
 	sem->ptr = ksem;
 
@@ -96,6 +96,7 @@ int sys__sem_wait ( void *p )
 		ksem->sem_value--;
 	}
 	else {
+		ksched_thread_ipc_block ( kthread_get_active () );
 		kthread_enqueue ( NULL, &ksem->queue );
 		kthreads_schedule ();
 	}
@@ -2,6 +2,7 @@
 #define _KERNEL_
 
 #include <arch/interrupts.h>
+#include <arch/smp.h>
 #include <kernel/time.h>
 #include <kernel/thread.h>
 #include <kernel/syscall.h>
@@ -19,6 +20,8 @@ char system_info[] = 	OS_NAME ": " NAME_MAJOR ":" NAME_MINOR ", "
 /* default standard input and output devices for user programs (threads) */
 void *u_stdin, *u_stdout;
 
+static void k_startup_ap ();
+
 /*!
  * First kernel function (after grub loads it to memory)
  * \param magic	Multiboot magic number
@@ -62,6 +65,11 @@ void k_startup ( unsigned long magic, unsigned long addr )
 
 	kprint ( "%s\n", system_info );
 
+	/* other processors (they wait until initialization is completed) */
+	arch_smp_init ();
+	if ( arch_cpu_count () > 1 )
+		kprint ( "Processors: %d\n", arch_cpu_count () );
+
 	/* thread subsystem */
 	kthreads_init ();
 
@@ -72,6 +80,21 @@ void k_startup ( unsigned long magic, unsigned long addr )
 		halt();
 	}
 
+	/* let other processors start with threads */
+	arch_smp_start ( k_startup_ap );
+
 	/* complete initialization by starting first thread */
 	arch_return_to_thread ();
 }
+
+/*! Starting function for other processors, after kernel is initialized */
+static void k_startup_ap ()
+{
+	arch_kernel_lock ();
+
+	kthreads_schedule (); /* idle thread or ready thread from other CPU */
+
+	arch_kernel_unlock ();
+
+	arch_return_to_thread ();
+}
@@ -6,10 +6,14 @@
 #include <arch/syscall.h>
 #include <arch/interrupts.h>
 #include <arch/processor.h>
+#include <arch/smp.h>
 
 #include <kernel/thread.h>
 #include <kernel/sched.h>
 #include <kernel/time.h>
+#include <kernel/rt_throttle.h>
+#include <kernel/reserve.h>
+#include <kernel/periodic.h>
 #include <kernel/semaphore.h>
 #include <kernel/monitor.h>
 #include <kernel/devices.h>
@@ -29,11 +33,21 @@ static int (*k_sysfunc[SYSFUNCS]) ( void *params ) =
 	sys__cancel_thread,
 	sys__thread_self,
 	sys__start_program,
+	sys__create_periodic_thread,
+	sys__wait_next_period,
+	sys__get_periodic_info,
 
 	sys__set_sched_params,
 	sys__get_sched_params,
 	sys__set_thread_sched_params,
 	sys__get_thread_sched_params,
+	sys__get_sched_latency,
+	sys__set_rt_throttle,
+	sys__get_rt_throttle,
+	sys__set_cpu_reserve,
+	sys__get_cpu_reserve,
+	sys__set_preempt_hint,
+	sys__thread_yield,
 
 	sys__set_errno,
 	sys__get_errno,
@@ -44,6 +58,7 @@ static int (*k_sysfunc[SYSFUNCS]) ( void *params ) =
 	sys__alarm_get,
 	sys__wait_for_alarm,
 	sys__alarm_remove,
+	sys__alarm_dispatch,
 
 	sys__sem_init,
 	sys__sem_destroy,
@@ -104,6 +119,9 @@ void k_syscall ( uint irqn )
 /*! Stop processor until next interrupt occurs - for idle thread only! */
 int sys__suspend ( void *p )
 {
+	/* interrupt will not return here, so let other processors in kernel */
+	arch_kernel_unlock_all ();
+
 	enable_interrupts ();
 	suspend ();
 
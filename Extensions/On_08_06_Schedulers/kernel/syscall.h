@@ -12,11 +12,21 @@ enum {
 	CANCEL_THREAD,
 	THREAD_SELF,
 	START_PROGRAM,
+	CREATE_PERIODIC_THREAD,
+	WAIT_NEXT_PERIOD,
+	GET_PERIODIC_INFO,
 
 	SET_SCHED_PARAMS,
 	GET_SCHED_PARAMS,
 	SET_THREAD_SCHED_PARAMS,
 	GET_THREAD_SCHED_PARAMS,
+	GET_SCHED_LATENCY,
+	SET_RT_THROTTLE,
+	GET_RT_THROTTLE,
+	SET_CPU_RESERVE,
+	GET_CPU_RESERVE,
+	SET_PREEMPT_HINT,
+	THREAD_YIELD,
 
 	SET_ERRNO,
 	GET_ERRNO,
@@ -27,6 +37,7 @@ enum {
 	ALARM_GET,
 	WAIT_FOR_ALARM,
 	ALARM_REMOVE,
+	ALARM_DISPATCH,
 
 	SEM_INIT,
 	SEM_DESTROY,
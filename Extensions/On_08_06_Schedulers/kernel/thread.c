@@ -5,11 +5,17 @@
 #include "thread.h"
 
 #include <arch/interrupts.h>
+#include <arch/smp.h>
 #include <kernel/memory.h>
 #include <kernel/devices.h>
 #include <kernel/kprint.h>
 #include <kernel/errno.h>
 #include <kernel/sched.h>
+#include <kernel/time.h>
+#include <kernel/rt_throttle.h>
+#include <kernel/reserve.h>
+#include <kernel/periodic.h>
+#include <kernel/monitor.h>
 #include <lib/bits.h>
 #include <lib/list.h>
 #include <lib/string.h>
@@ -20,35 +26,80 @@
 #endif
 
 static list_t all_threads; /* all threads */
+static int cancel_pending; /* threads canceled while active on other cpu */
 
-static kthread_t *active_thread = NULL; /* active thread */
+static kcpu_t kcpu[MAX_CPUS]; /* active and ready threads, per processor */
+static int kcpus; /* number of processors used */
 
-static kthread_q ready_q[PRIO_LEVELS]; /* ready threads organized by priority */
+/* thread active on processor executing this code */
+#define active_thread	( kcpu[arch_cpu_id ()].active )
 
 kprocess_t kernel_proc; /* kernel process (currently only for idle thread) */
 static list_t procs; /* list of all processes */
 
-/*! initialize thread structures and create idle thread */
+#ifdef	SCHED_LATENCY
+/* ready-to-active latency histograms, per priority and per policy */
+static sched_lat_t lat_prio[PRIO_LEVELS];
+static sched_lat_t lat_policy[SCHED_NUM];
+#endif
+
+/*! initialize thread structures and create idle threads */
 void kthreads_init ()
 {
+	kthread_t *kthread;
+	int i;
+
 	list_init ( &all_threads );
+	cancel_pending = 0;
 	list_init ( &procs );
 
-	/* queue for ready threads is empty */
-	kthread_ready_list_init ();
+	kcpus = arch_cpu_count ();
+
+	for ( i = 0; i < kcpus; i++ )
+	{
+		/* queue for ready threads is empty */
+		kthread_ready_list_init ( &kcpu[i] );
+
+		kcpu[i].active = NULL;
+		kcpu[i].resched = FALSE;
+	}
 
 	ksched_init ();
 
-	active_thread = NULL;
+	k_rt_init ();
+	k_reserve_init ();
+	k_periodic_init ();
 
-	/* initially create 'idle thread' */
+	/* initially create 'idle thread' for each processor */
 	kernel_proc.prog = NULL;
 	kernel_proc.stack_pool = NULL;
 	kernel_proc.m.start = NULL;
 	kernel_proc.m.size = (size_t) 0xffffffff;
+	kernel_proc.id = 0;
+	kernel_proc.run_time = 0;
+	kernel_proc.voluntary = kernel_proc.involuntary = 0;
+	kernel_proc.stride_tickets = kernel_proc.stride_thr_tickets = 0;
+	kernel_proc.rt_runtime = 0;
+	kernel_proc.rt_used = 0;
+	kernel_proc.rt_throttled = FALSE;
+	kernel_proc.res_budget = 0;
+	kernel_proc.res_exhausted = FALSE;
+	kernel_proc.alarm_dispatch = NULL;
+
+	for ( i = 0; i < kcpus; i++ )
+	{
+		kthread = kthread_create ( idle_thread, NULL, NULL, 0, 0, NULL,
+					   0, 0, &kernel_proc );
+		kthread->cpu = i;
+		kthread->state = THR_STATE_READY;
+		kthread->ref_cnt = 1;
 
-	(void) kthread_create ( idle_thread, NULL, NULL, 0, 0, NULL, 0, 1,
-				&kernel_proc );
+		kcpu[i].idle = kthread;
+	}
+
+	/* other processors ask for rescheduling with interrupt */
+	arch_register_interrupt_handler ( INT_RESCHEDULE,
+					  kthread_resched_handler, NULL );
 
 	kthreads_schedule ();
 }
@@ -118,6 +169,20 @@ kthread_t *kthread_start_process ( char *prog_name, void *param, int prio )
 
 	proc->thr_count = 0;
 
+	proc->id = k_new_unique_id ();
+	proc->run_time = 0;
+	proc->voluntary = proc->involuntary = 0;
+	proc->stride_tickets = proc->stride_thr_tickets = 0;
+	proc->rt_runtime = 0;
+	proc->rt_used = 0;
+	proc->rt_throttled = FALSE;
+	proc->res_budget = 0;
+	proc->res_period = proc->res_budget;
+	proc->res_used = proc->res_period_end = proc->res_budget;
+	proc->res_flags = 0;
+	proc->res_exhausted = FALSE;
+	proc->alarm_dispatch = NULL;
+
 	if ( !prio )
 		prio = proc->pi->prio;
 	if ( !prio )
@@ -203,25 +268,41 @@ kthread_t *kthread_create ( void *start_func, void *param, void *exit_func,
 
 	if ( prio < 0 ) prio = 0;
 	if ( prio >= PRIO_LEVELS ) prio = PRIO_LEVELS - 1;
-	kthread->prio = prio;
-
+	kthread->prio = kthread->base_prio = prio;
+	kthread->inherited_prio = -1;
+	list_init ( &kthread->locks );
+	kthread->cpu = arch_cpu_id ();
+	kthread->movable = FALSE;
 
 	arch_create_thread_context ( &kthread->context, start_func, param,
 				     exit_func, stack, stack_size, proc );
 	kthread->queue = NULL;
 	kthread->exit_status = 0;
+	kthread->cancel = FALSE;
 	kthreadq_init ( &kthread->join_queue );
 	kthread->ref_cnt = 0;
 
-	if ( run ) {
-		kthread_move_to_ready ( kthread, LAST );
-		kthread->ref_cnt = 1;
-	}
+	kthread->run_time = 0;
+	kthread->last_run = 0;
+	kthread->voluntary = kthread->involuntary = 0;
+
+	kthread->periodic.period = 0;
+	kthread->preempt_hint = NULL;
 
+	/* (schedulers and throttling may look at thread process) */
 	kthread->stack = stack;
 	kthread->stack_size = stack_size;
 	kthread->proc = proc;
 	kthread->proc->thr_count++;
+
+	/* scheduler may adjust priority before thread is put in ready list */
+	ksched_thread_add ( kthread, sched_policy );
+
+	if ( run ) {
+		kthread_move_to_ready ( kthread, LAST );
+		kthread->ref_cnt = 1;
+	}
+
 	kthread->private_storage = NULL;
 
 #ifdef	MESSAGES
@@ -229,31 +310,94 @@ kthread_t *kthread_create ( void *start_func, void *param, void *exit_func,
 #endif
 	list_append ( &all_threads, kthread, &kthread->all );
 
-	ksched_thread_add ( kthread, sched_policy );
-
 	return kthread;
 }
 
 /*!
- * Select ready thread with highest priority  as active
+ * Select ready thread with highest priority  as active (on this processor)
  * - if different from current, move current into ready queue (id not NULL) and
  *   move selected thread from ready queue to active queue
+ * - ready thread with higher priority may be taken from other processor
+ * - when there is no ready thread, SCHED_IDLE thread or (if there is none)
+ *   processor's idle thread is selected
  */
 void kthreads_schedule ()
 {
-	int highest;
+	kcpu_t *cpu = &kcpu[arch_cpu_id ()];
+	int highest, min_prio;
 	kthread_t *curr, *next;
+	ktime_t now;
 
-	curr = active_thread;
+	curr = cpu->active;
+	cpu->resched = FALSE;
 
-	highest = kthread_ready_list_highest ();
+	/*
+	 * charge real-time thread and thread of process with reservation; if
+	 * it reached its limit it is parked (or demoted to background)
+	 */
+	if ( curr && curr->state != THR_STATE_PASSIVE &&
+	     ( k_rt_thread ( curr ) || k_reserve_limited ( curr->proc ) ) )
+	{
+		now = k_get_ktime ();
+		kthread_account ( curr, now );
+		if ( k_rt_thread ( curr ) )
+			k_rt_update ( curr, now );
+		k_reserve_update ( curr->proc, now );
+
+		if ( curr->state == THR_STATE_ACTIVE && kthread_must_wait ( curr ) )
+			kthread_move_to_ready ( curr, FIRST );
+	}
+
+	/* priority ready thread must exceed to replace current one */
+	if ( curr && curr->state == THR_STATE_ACTIVE && curr != cpu->idle &&
+	     !kthread_background ( curr ) )
+		min_prio = curr->prio;
+	else
+		min_prio = -1;
 
-	/* must exist an thread to return to, 'curr' or first from 'ready' */
-	ASSERT ( ( curr && curr->state == THR_STATE_ACTIVE ) || highest >= 0 );
+	highest = kthread_ready_list_highest ( cpu );
+	if ( highest < min_prio )
+		highest = min_prio;
 
-	if ( !curr || curr->state != THR_STATE_ACTIVE ||
-		highest > curr->prio )
+	/* other processor may have ready thread with higher priority */
+	next = kthread_ready_list_steal ( cpu, highest );
+
+	if ( !next && highest > min_prio )
 	{
+		next = kthreadq_get ( &cpu->ready_q[highest] );
+		ASSERT ( next );
+
+		kthread_remove_from_ready ( next );
+	}
+	else if ( !next && ( !curr || curr->state != THR_STATE_ACTIVE ||
+			     curr == cpu->idle ) )
+	{
+		/* background threads run instead of idle thread */
+		next = kthreadq_remove ( &cpu->idle_q, NULL );
+
+		if ( !next && curr != cpu->idle )
+			next = cpu->idle;
+	}
+
+	if ( next )
+	{
+		now = k_get_ktime ();
+
+		/* finished thread is accounted in kthread_cancel */
+		if ( curr && curr != next && curr->state != THR_STATE_PASSIVE )
+		{
+			kthread_account ( curr, now );
+
+			if ( curr->state == THR_STATE_WAIT ) {
+				curr->voluntary++;
+				curr->proc->voluntary++;
+			}
+			else {
+				curr->involuntary++;
+				curr->proc->involuntary++;
+			}
+		}
+
 		if ( curr ) /* change active thread */
 		{
 			ksched_deactivate_thread ( curr );
@@ -263,21 +407,31 @@ void kthreads_schedule ()
 				kthread_move_to_ready ( curr, LAST );
 		}
 
-		next = kthreadq_remove ( &ready_q[highest], NULL );
-		ASSERT ( next );
+#ifdef	SCHED_LATENCY
+		if ( next->state == THR_STATE_READY && next != cpu->idle )
+			kthread_latency ( next, now );
+#endif
+
+		cpu->active = next;
+		next->cpu = cpu - kcpu;
+		next->state = THR_STATE_ACTIVE;
+		next->queue = NULL;
+		if ( next != curr )
+			next->last_run = now;
+		ksched_activate_thread ( next );
 
-		/* no more ready threads in list? */
-		if ( kthreadq_get ( &ready_q[highest] ) == NULL )
-			kthread_ready_list_set_empty ( highest );
+		if ( k_rt_thread ( next ) )
+			k_rt_arm ( next, now );
 
-		active_thread = next;
-		active_thread->state = THR_STATE_ACTIVE;
-		active_thread->queue = NULL;
-		ksched_activate_thread ( active_thread );
+		if ( k_reserve_limited ( next->proc ) )
+			k_reserve_arm ();
 	}
 
+	/* other processors may need to change their active threads */
+	kthread_resched_others ( cpu );
+
 	/* select 'active_thread' context */
-	arch_select_thread ( &active_thread->context );
+	arch_select_thread ( &cpu->active->context );
 }
 
 /*! operations on thread queues (blocked threads) --------------------------- */
@@ -340,96 +494,466 @@ int kthreadq_release_all ( kthread_q *q )
 
 /*! Ready thread list (multi-level organized; one level per priority) ------- */
 
-/* masks for fast searching for highest priority ready thread */
-#define RDY_MASKS ( ( PRIO_LEVELS + sizeof (word_t) - 1 ) / sizeof (word_t) )
-static word_t rdy_mask[ RDY_MASKS ];
-
 /*! Initialize ready thread list */
-static void kthread_ready_list_init ()
+static void kthread_ready_list_init ( kcpu_t *cpu )
 {
 	int i;
 
 	/* queue for ready threads is empty */
 	for ( i = 0; i < PRIO_LEVELS; i++ )
-		kthreadq_init ( &ready_q[i] );
+		kthreadq_init ( &cpu->ready_q[i] );
+
+	kthreadq_init ( &cpu->idle_q );
+
+	for ( i = 0; i < PRIO_LEVELS; i++ )
+		cpu->mov_cnt[i] = 0;
 
 	for ( i = 0; i < RDY_MASKS; i++ )
-		rdy_mask[i] = 0;
+		cpu->rdy_mask[i] = cpu->mov_mask[i] = 0;
 
+	cpu->rdy_summary = cpu->mov_summary = 0;
 }
 
 /*! Find and return priority of highest priority thread in ready list */
-static int kthread_ready_list_highest ()
+static int kthread_ready_list_highest ( kcpu_t *cpu )
 {
-	int i, first = -1;
+	return kthread_bitmap_highest ( cpu->rdy_mask, cpu->rdy_summary );
+}
 
-	for ( i = RDY_MASKS - 1; i >= 0; i-- )
-		if ( rdy_mask[i] )
-		{
-			first = i * sizeof (word_t) + msb_index ( rdy_mask[i] );
-			break;
-		}
+/*! Mark ready list for given priority (level) as non-empty */
+static void kthread_ready_list_set_not_empty ( kcpu_t *cpu, int index )
+{
+	kthread_bitmap_set ( cpu->rdy_mask, &cpu->rdy_summary, index );
+}
 
-	return first;
+/*! Mark ready list for given priority (level) as empty */
+static void kthread_ready_list_set_empty ( kcpu_t *cpu, int index )
+{
+	kthread_bitmap_clear ( cpu->rdy_mask, &cpu->rdy_summary, index );
 }
 
-/*! Mark ready list for given priority (level) as non-empty */
-static void kthread_ready_list_set_not_empty ( int index )
+/*! Two level bitmap: highest set bit (level), -1 if none is set */
+static inline int kthread_bitmap_highest ( word_t *mask, word_t summary )
+{
+	int i;
+
+	if ( !summary )
+		return -1;
+
+	i = msb_index ( summary );
+
+	return i * RDY_BITS + msb_index ( mask[i] );
+}
+
+/*! Two level bitmap: set bit for given level */
+static inline void kthread_bitmap_set ( word_t *mask, word_t *summary,
+					int index )
 {
 	int i, j;
 
-	i = index / sizeof (word_t);
-	j = index % sizeof (word_t);
+	i = index / RDY_BITS;
+	j = index % RDY_BITS;
 
-	rdy_mask[i] |= (word_t) ( 1 << j );
+	mask[i] |= ( (word_t) 1 ) << j;
+	*summary |= ( (word_t) 1 ) << i;
 }
 
-/*! Mark ready list for given priority (level) as empty */
-static void kthread_ready_list_set_empty ( int index )
+/*! Two level bitmap: clear bit for given level */
+static inline void kthread_bitmap_clear ( word_t *mask, word_t *summary,
+					  int index )
 {
 	int i, j;
 
-	i = index / sizeof (word_t);
-	j = index % sizeof (word_t);
+	i = index / RDY_BITS;
+	j = index % RDY_BITS;
 
-	rdy_mask[i] &= ~( (word_t) ( 1 << j ) );
+	mask[i] &= ~( ( (word_t) 1 ) << j );
+	if ( !mask[i] )
+		*summary &= ~( ( (word_t) 1 ) << i );
 }
 
 /*!
  * Move given thread (its descriptor) to ready threads
  * (as last or first in its priority queue)
+ * - thread is put in ready queues of processor it was last active on, except
+ *   threads of secondary schedulers which are kept on boot processor (their
+ *   parameters and scheduler timer are not per processor)
  */
 void kthread_move_to_ready ( kthread_t *kthread, int where )
 {
+	kcpu_t *cpu;
+
+	if ( kthread->sched.sched_policy != SCHED_FIFO )
+		kthread->cpu = 0;
+
+	cpu = &kcpu[kthread->cpu];
+
+#ifdef	SCHED_LATENCY
+	/* thread only moved between ready queues keeps its timestamp */
+	if ( kthread->state != THR_STATE_READY && kthread != cpu->idle )
+		kthread->ready_since = k_get_ktime ();
+#endif
+
 	kthread->state = THR_STATE_READY;
-	kthread->queue = &ready_q[kthread->prio];
+
+	if ( kthread == cpu->idle )
+	{
+		kthread->queue = NULL; /* selected only when nothing else is */
+		return;
+	}
+
+	if ( k_rt_throttled ( kthread ) )
+	{
+		/* over real-time limit: wait for next period outside ready queue */
+		kthread->queue = k_rt_parked ();
+		kthreadq_append ( kthread->queue, kthread );
+		k_rt_arm ( NULL, 0 );
+		return;
+	}
+
+	if ( k_reserve_waits ( kthread ) )
+	{
+		/* process used its reservation: wait for its next period */
+		kthread->queue = k_reserve_parked ();
+		kthreadq_append ( kthread->queue, kthread );
+		return;
+	}
+
+	if ( kthread_background ( kthread ) )
+	{
+		/* background thread: doesn't use priority ready queues */
+		kthread->queue = &cpu->idle_q;
+
+		if ( where == LAST )
+			kthreadq_append ( kthread->queue, kthread );
+		else
+			kthreadq_prepend ( kthread->queue, kthread );
+
+		return;
+	}
+
+	kthread->queue = &cpu->ready_q[kthread->prio];
 
 	if ( where == LAST )
 		kthreadq_append ( kthread->queue, kthread );
 	else
 		kthreadq_prepend ( kthread->queue, kthread );
 
-	kthread_ready_list_set_not_empty ( kthread->prio );
+	kthread_ready_list_set_not_empty ( cpu, kthread->prio );
+
+	/* count threads which other processors may take */
+	kthread->movable = ( kthread->sched.sched_policy == SCHED_FIFO );
+	if ( kthread->movable && !cpu->mov_cnt[kthread->prio]++ )
+		kthread_bitmap_set ( cpu->mov_mask, &cpu->mov_summary,
+				     kthread->prio );
+}
+
+/*!
+ * Keep ready threads of given priority sorted by 'cmp' instead of FIFO order
+ * (secondary scheduler which orders threads within priority level, e.g. CFS,
+ * calls this on initialization, while level is still empty)
+ */
+void kthread_ready_list_sort ( int prio, int (*cmp) ( void *, void * ) )
+{
+	int i;
+
+	ASSERT ( prio >= 0 && prio < PRIO_LEVELS && cmp );
+
+	for ( i = 0; i < kcpus; i++ )
+	{
+		ASSERT ( kthreadq_get ( &kcpu[i].ready_q[prio] ) == NULL );
+
+		kthreadq_init_sorted ( &kcpu[i].ready_q[prio], cmp );
+	}
 }
 
 /*! Remove given thread (its descriptor) from ready threads */
 kthread_t *kthread_remove_from_ready ( kthread_t *kthread )
 {
+	kcpu_t *cpu;
+
 	if ( !kthread )
 		return NULL;
 
-	kthread->queue = &ready_q[kthread->prio];
+	if ( kthread->queue == k_rt_parked () )
+		return kthreadq_remove ( kthread->queue, kthread );
+
+	if ( kthread->queue == k_reserve_parked () )
+		return kthreadq_remove ( kthread->queue, kthread );
+
+	cpu = &kcpu[kthread->cpu];
+
+	if ( kthread->queue == &cpu->idle_q )
+		return kthreadq_remove ( &cpu->idle_q, kthread );
+
+	kthread->queue = &cpu->ready_q[kthread->prio];
 
 	if ( kthreadq_remove ( kthread->queue, kthread ) != kthread )
 		return NULL;
 
 	/* no more ready threads in list? */
 	if ( kthreadq_get ( kthread->queue ) == NULL )
-		kthread_ready_list_set_empty ( kthread->prio );
+		kthread_ready_list_set_empty ( cpu, kthread->prio );
+
+	if ( kthread->movable && !--cpu->mov_cnt[kthread->prio] )
+		kthread_bitmap_clear ( cpu->mov_mask, &cpu->mov_summary,
+				       kthread->prio );
+
+	return kthread;
+}
+
+/*! Must thread wait for next period (of real-time limit or reservation)? */
+static inline int kthread_must_wait ( kthread_t *kthread )
+{
+	return k_rt_throttled ( kthread ) || k_reserve_waits ( kthread );
+}
+
+/*! Is thread in background (runs only when no other thread is ready)? */
+static inline int kthread_background ( kthread_t *kthread )
+{
+	if ( kthread->sched.sched_policy == SCHED_IDLE && kthread->prio == 0 )
+		return TRUE;
+
+	return k_reserve_demoted ( kthread );
+}
+
+/*! Is ready thread in other queue than kthread_move_to_ready would put it? */
+static int kthread_ready_misplaced ( kthread_t *kthread )
+{
+	kcpu_t *cpu = &kcpu[kthread->cpu];
+	kthread_q *q;
+
+	if ( k_rt_throttled ( kthread ) )
+		q = k_rt_parked ();
+	else if ( k_reserve_waits ( kthread ) )
+		q = k_reserve_parked ();
+	else if ( kthread_background ( kthread ) )
+		q = &cpu->idle_q;
+	else
+		q = &cpu->ready_q[kthread->prio];
+
+	return kthread->queue != q;
+}
+
+/*! Move misplaced ready threads (only of 'proc', if given) from given queue */
+static void kthread_ready_list_update_q ( kthread_q *q, kprocess_t *proc )
+{
+	kthread_t *kthread, *next;
+
+	kthread = kthreadq_get ( q );
+	while ( kthread )
+	{
+		next = kthreadq_get_next ( kthread );
+
+		if ( ( !proc || kthread->proc == proc ) &&
+		     kthread_ready_misplaced ( kthread ) )
+		{
+			kthread_remove_from_ready ( kthread );
+			kthread_move_to_ready ( kthread, LAST );
+		}
+
+		kthread = next;
+	}
+}
+
+/*!
+ * Limit was reached or renewed: move ready threads which are now misplaced
+ * (only those of 'proc', if given) from queue 'q' (if given), from ready
+ * queues with priority 'prio' or higher and from idle queues; processors
+ * running thread of 'proc' (or, without 'proc', one which must wait) reschedule
+ */
+void kthread_ready_list_update ( kthread_q *q, kprocess_t *proc, int prio )
+{
+	kthread_t *active;
+	int i, p;
+
+	if ( q )
+		kthread_ready_list_update_q ( q, proc );
+
+	for ( i = 0; i < kcpus; i++ )
+	{
+		for ( p = kthread_ready_list_highest ( &kcpu[i] ); p >= prio; p-- )
+			kthread_ready_list_update_q ( &kcpu[i].ready_q[p], proc );
+
+		kthread_ready_list_update_q ( &kcpu[i].idle_q, proc );
+
+		active = kcpu[i].active;
+		if ( active && ( proc ? active->proc == proc :
+				 kthread_must_wait ( active ) ) )
+			kthread_resched ( &kcpu[i] );
+	}
+}
+
+/*! Multiprocessor: moving threads between processors ----------------------- */
+
+/*!
+ * Find ready thread with highest priority, but greater than 'prio', which can
+ * be moved to other processor (threads of secondary schedulers can not)
+ * - levels with such threads are marked in 'mov_mask' bitmap
+ * \return found thread (still in ready queue) or NULL if there is none
+ */
+static kthread_t *kthread_ready_list_movable ( kcpu_t *cpu, int prio )
+{
+	kthread_t *kthread;
+	int p;
+
+	p = kthread_bitmap_highest ( cpu->mov_mask, cpu->mov_summary );
+	if ( p <= prio )
+		return NULL;
+
+	kthread = kthreadq_get ( &cpu->ready_q[p] );
+	while ( kthread && !kthread->movable )
+		kthread = kthreadq_get_next ( kthread );
+
+	ASSERT ( kthread );
 
 	return kthread;
 }
 
+/*!
+ * Take ready thread with priority greater than 'prio' from other processor
+ * (thread with highest priority among all other processors is taken)
+ * \return taken thread (removed from ready queue) or NULL if there is none
+ */
+static kthread_t *kthread_ready_list_steal ( kcpu_t *cpu, int prio )
+{
+	kthread_t *kthread, *found = NULL;
+	int i;
+
+	for ( i = 0; i < kcpus; i++ )
+	{
+		if ( &kcpu[i] == cpu )
+			continue;
+
+		kthread = kthread_ready_list_movable ( &kcpu[i], prio );
+		if ( kthread )
+		{
+			found = kthread;
+			prio = kthread->prio;
+		}
+	}
+
+	if ( found )
+		kthread_remove_from_ready ( found );
+
+	return found;
+}
+
+/*!
+ * Send reschedule interrupt to other processors whose active thread has lower
+ * priority than some ready thread they could take (idle ones in particular)
+ */
+static void kthread_resched_others ( kcpu_t *cpu )
+{
+	kthread_t *kthread;
+	kcpu_t *other;
+	int i, movable = -1, prio;
+
+	if ( kcpus < 2 )
+		return;
+
+	/* priority of best thread which could be moved to other processor */
+	for ( i = 0; i < kcpus; i++ )
+	{
+		kthread = kthread_ready_list_movable ( &kcpu[i], movable );
+		if ( kthread )
+			movable = kthread->prio;
+	}
+
+	for ( i = 0; i < kcpus; i++ )
+	{
+		other = &kcpu[i];
+
+		if ( other == cpu || !other->active || other->resched )
+			continue;
+
+		if ( other->active == other->idle )
+			prio = -1;
+		else
+			prio = other->active->prio;
+
+		if ( movable > prio ||
+		     kthread_ready_list_highest ( other ) > prio )
+			kthread_resched ( other );
+	}
+}
+
+/*! Request rescheduling on given processor (with interrupt) */
+static void kthread_resched ( kcpu_t *cpu )
+{
+	if ( cpu->resched || cpu == &kcpu[arch_cpu_id ()] )
+		return;
+
+	cpu->resched = TRUE;
+	arch_cpu_signal ( cpu - kcpu );
+}
+
+/*!
+ * Reschedule interrupt handler (other processor made some thread ready or
+ * canceled thread active on this processor)
+ */
+static int kthread_resched_handler ( unsigned int inum, void *device )
+{
+	if ( cancel_pending )
+		kthread_cancel_pending ();
+
+	kthreads_schedule ();
+
+	return 0;
+}
+
+/*!
+ * Finish cancel of threads canceled while active on other processor
+ * - interrupt came from user mode, so active thread can be removed (there is
+ *   no system call in progress which would still use its descriptor)
+ * - canceled thread which meanwhile became active on yet another processor
+ *   is left to that processor
+ */
+static void kthread_cancel_pending ()
+{
+	kthread_t *kthread, *next;
+
+	kthread = list_get ( &all_threads, FIRST );
+	while ( kthread )
+	{
+		next = list_get_next ( &kthread->all );
+
+		if ( kthread->cancel && kthread->state == THR_STATE_ACTIVE &&
+		     kthread != active_thread )
+			kthread_resched ( &kcpu[kthread->cpu] );
+		else if ( kthread->cancel )
+			kthread_cancel ( kthread, kthread->exit_status );
+
+		kthread = next;
+	}
+}
+
+/*!
+ * Compare threads by priority (for priority ordered queues): thread with
+ * higher priority is "smaller", i.e. is put before
+ */
+static int kthread_prio_cmp ( void *a, void *b )
+{
+	kthread_t *ta = a, *tb = b;
+
+	return tb->prio - ta->prio;
+}
+
+/*! Change priority of blocked thread (re-position it in sorted queue) */
+static void kthread_change_wait_prio ( kthread_t *kthread, int prio )
+{
+	if ( kthread->queue && ( kthread->queue->flags & KTHREADQ_SORTED ) &&
+	     kthread->prio != prio )
+	{
+		kthreadq_remove ( kthread->queue, kthread );
+		kthread->prio = prio;
+		kthreadq_append ( kthread->queue, kthread );
+	}
+	else {
+		kthread->prio = prio;
+	}
+}
+
 /*! Internal function for removing (freeing) thread descriptor */
 static void kthread_remove_descriptor ( kthread_t *kthread )
 {
@@ -447,30 +971,71 @@ static void kthread_remove_descriptor ( kthread_t *kthread )
  */
 int kthread_cancel ( kthread_t *kthread, int exit_status )
 {
+	kcpu_t *cpu = &kcpu[arch_cpu_id ()];
+	kthread_q *queue = NULL;
+
 	if ( kthread->state == THR_STATE_PASSIVE )
 		return SUCCESS; /* thread is already finished */
 
+	if ( kthread->state == THR_STATE_ACTIVE && kthread != cpu->active )
+	{
+		/* active on other processor: that processor finishes cancel
+		   when it handles reschedule interrupt */
+		if ( kcpu[kthread->cpu].active != kthread )
+			return E_DONT_EXIST; /* thread descriptor corrupted ! */
+
+		if ( !kthread->cancel )
+		{
+			kthread->cancel = TRUE;
+			cancel_pending++;
+		}
+		kthread->exit_status = exit_status;
+		kthread_resched ( &kcpu[kthread->cpu] );
+
+		return SUCCESS;
+	}
+
+	if ( kthread->state != THR_STATE_READY &&
+	     kthread->state != THR_STATE_WAIT &&
+	     kthread->state != THR_STATE_ACTIVE )
+		return E_INVALID_HANDLE; /* thread descriptor corrupted ! */
+
+	/*
+	 * secondary scheduler may hold thread in its own queue; it is removed
+	 * first since scheduler may then put it in ready queue (state changes)
+	 */
+	ksched_thread_remove ( kthread, kthread->sched.sched_policy );
+
 	if ( kthread->state == THR_STATE_READY )
 	{
 		/* remove target 'thread' from its queue */
-		kthreadq_remove ( kthread->queue, kthread );
-		if ( kthreadq_get ( &ready_q[kthread->prio] ) == NULL )
-			kthread_ready_list_set_empty ( kthread->prio );
+		kthread_remove_from_ready ( kthread );
 	}
 	else if ( kthread->state == THR_STATE_WAIT )
 	{
 		/* remove target 'thread' from its queue */
-		kthreadq_remove ( kthread->queue, kthread );
+		queue = kthread->queue;
+		kthreadq_remove ( queue, kthread );
 	}
 	else if ( kthread->state == THR_STATE_ACTIVE )
 	{
-		if ( kthread != active_thread )
-			return E_DONT_EXIST; /* thread descriptor corrupted ! */
-
-		active_thread->state = THR_STATE_PASSIVE;
+		/* thread exits: account it while its process still exists */
+		kthread_account ( kthread, k_get_ktime () );
+		kthread->voluntary++;
+		kthread->proc->voluntary++;
 	}
-	else {
-		return E_INVALID_HANDLE; /* thread descriptor corrupted ! */
+
+	/* release monitors it holds and (maybe) priority it passed on */
+	k_monitor_thread_cancel ( kthread, queue );
+
+	k_periodic_remove ( kthread );
+
+	kthread->state = THR_STATE_PASSIVE;
+
+	if ( kthread->cancel )
+	{
+		kthread->cancel = FALSE;
+		cancel_pending--;
 	}
 
 	kthread->ref_cnt--;
@@ -481,6 +1046,10 @@ int kthread_cancel ( kthread_t *kthread, int exit_status )
 #ifdef	MESSAGES
 	k_msgq_clean ( &kthread->msg.msgq );
 #endif
+	/* processor must not use thread (its stack and descriptor) any more */
+	if ( cpu->active == kthread )
+		cpu->active = NULL;
+
 	/* release thread stack */
 	if ( kthread->stack )
 	{
@@ -493,9 +1062,14 @@ int kthread_cancel ( kthread_t *kthread, int exit_status )
 
 	kthread_delete_private_storage ( kthread, kthread->private_storage );
 
+	/* alarm dispatch thread finishes with other threads in process */
+	if ( kthread->proc->alarm_dispatch )
+		k_alarm_dispatch_thread_exit ( kthread->proc, kthread );
+
 	if ( kthread->proc->thr_count == 0 && kthread->proc->pi )
 	{
 		/* last (non-kernel) thread - remove process */
+		k_free_unique_id ( kthread->proc->id );
 		kfree ( kthread->proc->pi );
 		ASSERT ( list_remove ( &procs, FIRST, &kthread->proc->all ) );
 		kfree ( kthread->proc );
@@ -681,7 +1255,14 @@ int sys__cancel_thread ( void *p )
 		EXIT ( kthread_cancel ( kthread, -1 ) );
 		break;
 
-	case THR_STATE_ACTIVE: /* can't cancel itself (or could!?) */
+	case THR_STATE_ACTIVE:
+		/* can't cancel itself, but can thread active on other processor */
+		if ( kthread == active_thread )
+			EXIT ( E_INVALID_HANDLE );
+
+		EXIT ( kthread_cancel ( kthread, -1 ) );
+		break;
+
 	default:
 		EXIT ( E_INVALID_HANDLE ); /* thread descriptor corrupted ! */
 	}
@@ -779,37 +1360,208 @@ int sys__start_program ( void *p )
 	RETURN ( SUCCESS );
 }
 
-/*! Display info on threads */
-int kthread_info ()
+/*!
+ * Get scheduler latency histogram
+ * \param type LAT_PRIO or LAT_POLICY
+ * \param index Priority or scheduling policy (depending on 'type')
+ * \param lat Where to store histogram (user address)
+ * \param reset Clear histogram after it is copied?
+ */
+int sys__get_sched_latency ( void *p )
 {
-	kthread_t *kthread;
-	int i = 1;
+#ifdef	SCHED_LATENCY
+	int type, index, reset;
+	sched_lat_t *lat, *hist;
+
+	type = *( (int *) p ); p += sizeof (int);
+	index = *( (int *) p ); p += sizeof (int);
+	lat = *( (void **) p ); p += sizeof (void *);
+	reset = *( (int *) p );
+
+	lat = U2K_GET_ADR ( lat, active_thread->proc );
+	ASSERT_ERRNO_AND_EXIT ( lat, E_PARAM_NULL );
+
+	if ( type == LAT_PRIO && index >= 0 && index < PRIO_LEVELS )
+		hist = &lat_prio[index];
+	else if ( type == LAT_POLICY && index >= 0 && index < SCHED_NUM )
+		hist = &lat_policy[index];
+	else
+		EXIT ( E_INVALID_ARGUMENT );
 
-	kprint ( "Threads info\n" );
+	*lat = *hist;
 
-	kprint ( "[this]\tid=%d in process at %x, size=%d\n",
-		  active_thread->id, active_thread->proc->m.start,
-		  active_thread->proc->m.size );
+	if ( reset )
+		memset ( hist, 0, sizeof (sched_lat_t) );
 
-	kprint ( "\tprio=%d, state=%d, ret_val=%d\n",
-		  active_thread->prio, active_thread->state,
-		  active_thread->exit_status );
+	EXIT ( SUCCESS );
+#else
+	EXIT ( E_UNSUPPORTED );
+#endif
+}
+
+/*!
+ * Copy statistics of all threads and processes into 'buffer'
+ * (threads_info_t followed by thread_info_t and process_info_t elements)
+ * \param buffer Where to copy statistics
+ * \param size Size of 'buffer'
+ * \return 0 if successful, E_TOO_BIG if buffer not big enough (then only
+ *         number of threads and processes is set in threads_info_t)
+ */
+int kthread_info ( void *buffer, size_t size )
+{
+	threads_info_t *info = buffer;
+	thread_info_t *ti;
+	process_info_t *pi;
+	kthread_t *kthread;
+	kprocess_t *proc;
+	ktime_t now;
+	int i;
+
+	if ( size < sizeof (threads_info_t) )
+		return E_TOO_BIG;
 
+	info->threads = 0;
 	kthread = list_get ( &all_threads, FIRST );
-	while ( kthread )
+	for ( ; kthread; kthread = list_get_next ( &kthread->all ) )
+		info->threads++;
+
+	info->processes = 1; /* kernel_proc */
+	proc = list_get ( &procs, FIRST );
+	for ( ; proc; proc = list_get_next ( &proc->all ) )
+		info->processes++;
+
+	if ( size < sizeof (threads_info_t) +
+		    info->threads * sizeof (thread_info_t) +
+		    info->processes * sizeof (process_info_t) )
+		return E_TOO_BIG;
+
+	/* include time active threads used since they were activated */
+	now = k_get_ktime ();
+	ktime_to_time ( now, &info->time );
+	for ( i = 0; i < kcpus; i++ )
+		if ( kcpu[i].active )
+			kthread_account ( kcpu[i].active, now );
+
+	ti = (void *) ( info + 1 );
+	kthread = list_get ( &all_threads, FIRST );
+	for ( ; kthread; kthread = list_get_next ( &kthread->all ), ti++ )
+	{
+		ti->id = kthread->id;
+		ti->proc_id = kthread->proc->id;
+		ti->prio = kthread->prio;
+		ti->sched_policy = kthread->sched.sched_policy;
+		ti->state = kthread->state;
+		ti->cpu = kthread->cpu;
+
+		ktime_to_time ( kthread->run_time, &ti->run_time );
+		ktime_to_time ( kthread->last_run, &ti->last_run );
+		ti->voluntary = kthread->voluntary;
+		ti->involuntary = kthread->involuntary;
+	}
+
+	pi = (void *) ti;
+	proc = &kernel_proc;
+	for ( i = 0; i < info->processes; i++, pi++ )
+	{
+		pi->id = proc->id;
+		pi->threads = proc->thr_count;
+		ktime_to_time ( proc->run_time, &pi->run_time );
+		pi->voluntary = proc->voluntary;
+		pi->involuntary = proc->involuntary;
+
+		if ( proc == &kernel_proc )
+			proc = list_get ( &procs, FIRST );
+		else
+			proc = list_get_next ( &proc->all );
+	}
+
+	return SUCCESS;
+}
+
+#ifdef	SCHED_LATENCY
+/*! Add latency from 'ready_since' until 'now' to histograms of given thread */
+static void kthread_latency ( kthread_t *kthread, ktime_t now )
+{
+	sched_lat_t *hist[2];
+	ktime_t t = now - kthread->ready_since;
+	uint us, ns;
+	int i, b;
+
+	if ( t < 0 )
+		return;
+	else if ( t >= 4000 * KTIME_SEC )
+		us = (uint) -1; /* would overflow */
+	else
+		us = div_64_32 ( t, 1000, &ns );
+
+	b = us ? msb_index ( us ) + 1 : 0;
+	if ( b >= LAT_BUCKETS )
+		b = LAT_BUCKETS - 1;
+
+	hist[0] = &lat_prio[kthread->prio];
+	hist[1] = &lat_policy[kthread->sched.sched_policy];
+
+	for ( i = 0; i < 2; i++ )
 	{
-		kprint ( "[%d]\tid=%d in process at %x, size=%d\n",
-			 i++, kthread->id, kthread->proc->m.start,
-			 kthread->proc->m.size );
+		hist[i]->count[b]++;
+		hist[i]->samples++;
+		if ( hist[i]->max < us )
+			hist[i]->max = us;
+	}
+}
+#endif
 
-		kprint ( "\tprio=%d, state=%d, ret_val=%d\n",
-			 kthread->prio, kthread->state,
-			 kthread->exit_status );
+/*! Add time passed since 'last_run' to thread (and its process) run time */
+void kthread_account ( kthread_t *kthread, ktime_t now )
+{
+	ktime_t t = now - kthread->last_run;
 
-		kthread = list_get_next ( &kthread->all );
+	kthread->last_run = now;
+
+	if ( t < 0 )
+		return;
+
+	kthread->run_time += t;
+	kthread->proc->run_time += t;
+
+	k_reserve_charge ( kthread->proc, t );
+	k_rt_charge ( kthread, t );
+}
+
+/*!
+ * Set (or clear) preemption deferral hint for calling thread
+ * \param hint Address of thread's hint word (see PREEMPT_DEFER); NULL to clear
+ */
+int sys__set_preempt_hint ( void *p )
+{
+	int *hint;
+
+	hint = *( (void **) p );
+
+	if ( hint )
+	{
+		hint = U2K_GET_ADR ( hint, active_thread->proc );
+		ASSERT_ERRNO_AND_EXIT ( hint, E_INVALID_ARGUMENT );
+		*hint &= ~PREEMPT_YIELD;
 	}
 
-	return 0;
+	active_thread->preempt_hint = hint;
+
+	EXIT ( SUCCESS );
+}
+
+/*! Give up processor to other ready threads with same priority */
+int sys__thread_yield ( void *p )
+{
+	if ( active_thread->preempt_hint )
+		*active_thread->preempt_hint &= ~PREEMPT_YIELD;
+
+	kthread_move_to_ready ( active_thread, LAST );
+
+	SET_ERRNO ( SUCCESS );
+	kthreads_schedule ();
+
+	RETURN ( SUCCESS );
 }
 
 /*! Set and get current thread error status */
@@ -833,6 +1585,34 @@ inline void *kthread_get_active ()
 {
 	return (void *) active_thread;
 }
+
+/*! Get time when thread was last activated (or charged) */
+ktime_t kthread_get_last_run ( kthread_t *kthread )
+{
+	return kthread->last_run;
+}
+
+/*! Get thread active on processor 'cpu' (NULL if it is not active anymore) */
+kthread_t *kthread_get_cpu_active ( int cpu )
+{
+	kthread_t *kthread = kcpu[cpu].active;
+
+	if ( kthread && kthread->state == THR_STATE_ACTIVE )
+		return kthread;
+	else
+		return NULL;
+}
+
+/*! Iterate through processes: kernel one first (for NULL), then others */
+kprocess_t *kthread_get_next_process ( kprocess_t *proc )
+{
+	if ( !proc )
+		return &kernel_proc;
+	else if ( proc == &kernel_proc )
+		return list_get ( &procs, FIRST );
+	else
+		return list_get_next ( &proc->all );
+}
 inline void *kthread_get_context ( kthread_t *kthread )
 {
 	if ( kthread )
@@ -855,7 +1635,12 @@ int kthread_set_prio ( kthread_t *kthread, int prio )
 	if ( !kthr )
 		kthr = active_thread;
 
-	old_prio = kthr->prio;
+	old_prio = kthr->base_prio;
+
+	/* inherited priority (if higher) stays in effect */
+	kthr->base_prio = prio;
+	if ( kthr->inherited_prio > prio )
+		prio = kthr->inherited_prio;
 
 	/* change thread priority:
 	(i)	if its active: change priority and move to ready
@@ -866,6 +1651,12 @@ int kthread_set_prio ( kthread_t *kthread, int prio )
 	{
 	case THR_STATE_ACTIVE:
 		kthr->prio = prio;
+		if ( kthr != active_thread )
+		{
+			/* active on other processor - let it reschedule */
+			kthread_resched ( &kcpu[kthr->cpu] );
+			break;
+		}
 		kthread_move_to_ready ( kthr, LAST );
 		kthreads_schedule ();
 		break;
@@ -877,8 +1668,8 @@ int kthread_set_prio ( kthread_t *kthread, int prio )
 		kthreads_schedule ();
 		break;
 
-	case THR_STATE_WAIT: /* as now there is only FIFO queue */
-		kthr->prio = prio;
+	case THR_STATE_WAIT:
+		kthread_change_wait_prio ( kthr, prio );
 		break;
 
 	case THR_STATE_PASSIVE: /* report error or just change priority? */
@@ -889,6 +1680,60 @@ int kthread_set_prio ( kthread_t *kthread, int prio )
 	return old_prio;
 }
 
+/*!
+ * Set priority thread inherits from threads blocked on monitors it holds
+ * (-1 if none); thread runs with higher of its own and inherited priority
+ * - 'kthreads_schedule' should follow this call before exiting from kernel!
+ * \return TRUE if thread priority is changed, FALSE otherwise
+ */
+int kthread_set_inherited_prio ( kthread_t *kthread, int prio )
+{
+	int new_prio;
+
+	kthread->inherited_prio = prio;
+
+	new_prio = kthread->base_prio;
+	if ( prio > new_prio )
+		new_prio = prio;
+
+	if ( new_prio == kthread->prio )
+		return FALSE;
+
+	if ( kthread->state == THR_STATE_READY )
+	{
+		kthread_remove_from_ready ( kthread );
+		kthread->prio = new_prio;
+		kthread_move_to_ready ( kthread, LAST );
+	}
+	else if ( kthread->state == THR_STATE_WAIT )
+	{
+		kthread_change_wait_prio ( kthread, new_prio );
+	}
+	else {
+		kthread->prio = new_prio;
+	}
+
+	return TRUE;
+}
+
+/*! Monitors locked by thread (list is maintained by monitor.c) */
+inline list_t *kthread_get_locks ( kthread_t *kthread )
+{
+	if ( kthread )
+		return &kthread->locks;
+	else
+		return &active_thread->locks;
+}
+
+/*! Queue in which thread is (NULL if active) */
+inline kthread_q *kthread_get_queue ( kthread_t *kthread )
+{
+	if ( kthread )
+		return kthread->queue;
+	else
+		return active_thread->queue;
+}
+
 inline kthread_sched_data_t *kthread_get_sched_param ( kthread_t *kthread )
 {
 	if ( kthread )
@@ -897,6 +1742,19 @@ inline kthread_sched_data_t *kthread_get_sched_param ( kthread_t *kthread )
 		return &active_thread->sched;
 }
 
+inline kperiodic_t *kthread_get_periodic ( kthread_t *kthread )
+{
+	if ( kthread )
+		return &kthread->periodic;
+	else
+		return &active_thread->periodic;
+}
+
+inline volatile int *kthread_get_preempt_hint ( kthread_t *kthread )
+{
+	return kthread->preempt_hint;
+}
+
 inline kprocess_t *kthread_get_process ( kthread_t *kthread )
 {
 	if ( kthread )
@@ -930,29 +1788,54 @@ inline int kthread_is_ready ( kthread_t *kthread )
 inline void kthreadq_init ( kthread_q *q )
 {
 	list_init ( &q->q );
+	q->flags = 0;
+}
+inline void kthreadq_init_sorted ( kthread_q *q, int (*cmp) ( void *, void * ) )
+{
+	list_init ( &q->q );
+	tree_init ( &q->t, cmp );
+	q->flags = KTHREADQ_SORTED;
+}
+inline void kthreadq_init_prio ( kthread_q *q )
+{
+	kthreadq_init_sorted ( q, kthread_prio_cmp );
 }
 inline void kthreadq_append ( kthread_q *q, kthread_t *kthread )
 {
-	list_append ( &q->q, kthread, &kthread->ql );
+	if ( q->flags & KTHREADQ_SORTED )
+		tree_add ( &q->t, kthread, &kthread->qt );
+	else
+		list_append ( &q->q, kthread, &kthread->ql );
 }
 inline void kthreadq_prepend ( kthread_q *q, kthread_t *kthread )
 {
-	list_prepend ( &q->q, kthread, &kthread->ql );
+	if ( q->flags & KTHREADQ_SORTED )
+		tree_add ( &q->t, kthread, &kthread->qt );
+	else
+		list_prepend ( &q->q, kthread, &kthread->ql );
 }
 inline kthread_t *kthreadq_remove ( kthread_q *q, kthread_t *kthread )
 {
-	if ( kthread )
+	if ( q->flags & KTHREADQ_SORTED )
+		return tree_remove ( &q->t, kthread ? &kthread->qt : NULL );
+	else if ( kthread )
 		return list_remove ( &q->q, FIRST, &kthread->ql );
 	else
 		return list_remove ( &q->q, FIRST, NULL );
 }
 inline kthread_t *kthreadq_get ( kthread_q *q )
 {
-	return list_get ( &q->q, FIRST );
+	if ( q->flags & KTHREADQ_SORTED )
+		return tree_get_first ( &q->t );
+	else
+		return list_get ( &q->q, FIRST );
 }
 inline kthread_t *kthreadq_get_next ( kthread_t *kthread )
 {
-	return list_get_next ( &kthread->ql );
+	if ( kthread->queue && ( kthread->queue->flags & KTHREADQ_SORTED ) )
+		return tree_get_next ( &kthread->qt );
+	else
+		return list_get_next ( &kthread->ql );
 }
 
 /*! Temporary storage for blocked thread (save specific context before wait) */
@@ -11,6 +11,10 @@ int sys__thread_self ( void *p );
 
 int sys__start_program ( void *p );
 
+int sys__get_sched_latency ( void *p );
+int sys__set_preempt_hint ( void *p );
+int sys__thread_yield ( void *p );
+
 int sys__set_errno ( void *p );
 int sys__get_errno ( void *p );
 
@@ -18,15 +22,21 @@ int sys__get_errno ( void *p );
 
 #include <lib/types.h>
 #include <lib/list.h>
+#include <lib/ktime.h>
+#include <lib/tree.h>
 
 /*! Thread queue */
 typedef struct _kthread_q_
 {
 	list_t q;		/* queue implementation in list.h/list.c */
-	/* uint flags; */	/* various flags, e.g. sort order */
+	tree_t t;		/* sorted queue (tree.h/tree.c) */
+	uint flags;		/* various flags, e.g. sort order */
 }
 kthread_q;
 
+/* thread queue flags */
+#define KTHREADQ_SORTED	1	/* threads are ordered by 't.cmp', not FIFO */
+
 #ifndef _K_THREAD_C_	/* only 'kernel/thread.c' 'knows' thread descriptor */
 typedef void *kthread_t;
 #else /* only for 'kernel/thread.c' */
@@ -37,6 +47,7 @@ typedef struct _kthread_t_ kthread_t;
 #include <kernel/memory.h>
 #include <kernel/messages.h>
 #include <kernel/sched.h>
+#include <kernel/periodic.h>
 
 /*! Interface for kernel ---------------------------------------------------- */
 void kthreads_init ();
@@ -49,15 +60,27 @@ kthread_t *kthread_create ( void *start_func, void *param, void *exit_func,
 void kthreads_schedule ();
 void kthread_move_to_ready ( kthread_t *kthr, int where );
 kthread_t *kthread_remove_from_ready ( kthread_t *kthr );
+void kthread_ready_list_sort ( int prio, int (*cmp) ( void *, void * ) );
+void kthread_ready_list_update ( kthread_q *q, kprocess_t *proc, int prio );
+void kthread_account ( kthread_t *kthread, ktime_t now );
 int kthread_cancel ( kthread_t *kthread, int exit_status );
 
+extern kprocess_t kernel_proc;
+
 /*! Get-ers and Set-ers */
 extern inline void *kthread_get_active ();
+kthread_t *kthread_get_cpu_active ( int cpu );
+kprocess_t *kthread_get_next_process ( kprocess_t *proc );
+ktime_t kthread_get_last_run ( kthread_t *kthread );
 extern inline void *kthread_get_context ( kthread_t *thread );
 extern inline int kthread_get_prio ( kthread_t *kthread );
 int kthread_set_prio ( kthread_t *kthread, int prio );
+int kthread_set_inherited_prio ( kthread_t *kthread, int prio );
+extern inline list_t *kthread_get_locks ( kthread_t *kthread );
+extern inline kthread_q *kthread_get_queue ( kthread_t *kthread );
 extern inline kprocess_t *kthread_get_process ( kthread_t *kthread );
 extern inline int kthread_get_id ( kthread_t *kthread );
+extern inline volatile int *kthread_get_preempt_hint ( kthread_t *kthread );
 
 extern inline int kthread_is_ready ( kthread_t *kthread );
 
@@ -67,6 +90,7 @@ extern inline void kthread_set_private_storage ( kthread_t *kthr, void *ps );
 extern inline void *kthread_get_private_storage ( kthread_t *kthr );
 
 extern inline kthread_sched_data_t *kthread_get_sched_param ( kthread_t *kthr );
+extern inline kperiodic_t *kthread_get_periodic ( kthread_t *kthr );
 
 
 #ifdef	MESSAGES
@@ -77,6 +101,9 @@ extern inline kthread_t *kthread_get_descriptor ( thread_t *thr );
 
 /*! Thread queue manipulation */
 extern inline void kthreadq_init ( kthread_q *q );
+extern inline void kthreadq_init_sorted ( kthread_q *q,
+					  int (*cmp) ( void *, void * ) );
+extern inline void kthreadq_init_prio ( kthread_q *q );
 extern inline void kthreadq_append ( kthread_q *q, kthread_t *kthr );
 extern inline void kthreadq_prepend ( kthread_q *q, kthread_t *kthread );
 extern inline kthread_t *kthreadq_remove ( kthread_q *q, kthread_t *kthr );
@@ -94,7 +121,7 @@ extern inline void *kthread_get_qdata ( kthread_t *kthr );
 extern inline void kthread_set_errno ( kthread_t *kthr, int error_number );
 extern inline int kthread_get_errno ( kthread_t *kthr );
 
-int kthread_info ();
+int kthread_info ( void *buffer, size_t size );
 
 
 #ifdef _K_THREAD_C_ /* rest of the file is only for kernel/thread.c */
@@ -111,11 +138,20 @@ struct _kthread_t_
 	int state;		/* thread state */
 
 	list_h ql;		/* list element for "thread state" list */
+	tree_h qt;		/* tree element for sorted "thread state" queue */
 
 	int prio;		/* priority - primary scheduling parameter */
+	int base_prio;		/* priority without inherited one */
+	int inherited_prio;	/* priority inherited from threads blocked on
+				   monitors this thread holds (-1 if none) */
+	list_t locks;		/* monitors locked by this thread */
 
 	kthread_sched_data_t sched;	/* secondary scheduler parameters */
 
+	int cpu;		/* processor thread was last active on (in
+				   whose ready queues thread is put) */
+	int movable;		/* counted in 'mov_cnt' of its ready queue */
+
 	kthread_q *queue;	/* in witch queue (if not active) */
 	void *qdata;		/* temporary storage for data while waiting */
 
@@ -135,10 +171,26 @@ struct _kthread_t_
 	list_h all;		/* list element for list of all threads */
 
 	int exit_status;	/* status with which thread exited */
+	int cancel;		/* canceled while active on other processor */
 
 	int errno;		/* exit status of last function call */
 
 	int ref_cnt;		/* can we free this descriptor? */
+
+	/* statistics */
+	ktime_t run_time;	/* processor time used */
+	ktime_t last_run;	/* when thread was last activated/deactivated */
+	uint voluntary;		/* switches when thread blocked (or exited) */
+	uint involuntary;	/* switches when thread was preempted */
+
+	kperiodic_t periodic;	/* periodic thread data */
+
+	volatile int *preempt_hint; /* preemption deferral hint (kernel address
+				   of thread's word, NULL if not set) */
+
+#ifdef	SCHED_LATENCY
+	ktime_t ready_since;	/* when thread was put into ready queue */
+#endif
 };
 
 /*! Thread states */
@@ -149,14 +201,76 @@ enum {
 	THR_STATE_PASSIVE
 };
 
+/*
+ * Two level bitmap for fast searching for highest priority ready thread:
+ * bit 'j' in 'rdy_mask[i]' marks non-empty ready queue for priority
+ * i * RDY_BITS + j, while bit 'i' in 'rdy_summary' marks non-zero 'rdy_mask[i]'
+ * (finding highest priority takes two bit scans, regardless of PRIO_LEVELS)
+ */
+#define RDY_BITS	( sizeof (word_t) * 8 )
+#define RDY_MASKS	( ( PRIO_LEVELS + RDY_BITS - 1 ) / RDY_BITS )
+
+#if PRIO_LEVELS > 32 * 32
+#error PRIO_LEVELS too big for two level ready bitmap (max 32 * 32)
+#endif
+
+/*! Processor: its active thread and ready threads */
+typedef struct _kcpu_t_
+{
+	kthread_t *active;	/* active thread */
+	kthread_t *idle;	/* idle thread (not kept in ready queues) */
+	kthread_q idle_q;	/* ready SCHED_IDLE threads (selected only when
+				   no other thread is ready, before idle) */
+
+	kthread_q ready_q[PRIO_LEVELS]; /* ready threads organized by priority */
+	word_t rdy_mask[ RDY_MASKS ];
+	word_t rdy_summary;
+
+	int mov_cnt[PRIO_LEVELS];	/* ready threads other processors may
+					   take (SCHED_FIFO), per priority */
+	word_t mov_mask[ RDY_MASKS ];	/* levels with such threads */
+	word_t mov_summary;
+
+	int resched;		/* reschedule interrupt sent, not yet handled */
+}
+kcpu_t;
+
 /* "ready" queue manipulation */
-static void kthread_ready_list_init ();
-static int kthread_ready_list_highest ();
-static void kthread_ready_list_set_not_empty ( int index );
-static void kthread_ready_list_set_empty ( int index );
+static void kthread_ready_list_init ( kcpu_t *cpu );
+static int kthread_ready_list_highest ( kcpu_t *cpu );
+static void kthread_ready_list_set_not_empty ( kcpu_t *cpu, int index );
+static void kthread_ready_list_set_empty ( kcpu_t *cpu, int index );
+static inline int kthread_bitmap_highest ( word_t *mask, word_t summary );
+static inline void kthread_bitmap_set ( word_t *mask, word_t *summary,
+					int index );
+static inline void kthread_bitmap_clear ( word_t *mask, word_t *summary,
+					  int index );
+
+/* multiprocessor: moving threads between processors */
+static kthread_t *kthread_ready_list_movable ( kcpu_t *cpu, int prio );
+static kthread_t *kthread_ready_list_steal ( kcpu_t *cpu, int prio );
+static void kthread_resched_others ( kcpu_t *cpu );
+static void kthread_resched ( kcpu_t *cpu );
+static int kthread_resched_handler ( unsigned int inum, void *device );
+static void kthread_cancel_pending ();
+static inline int kthread_must_wait ( kthread_t *kthread );
+static int kthread_ready_misplaced ( kthread_t *kthread );
+static void kthread_ready_list_update_q ( kthread_q *q, kprocess_t *proc );
 
 static void kthread_remove_descriptor ( kthread_t *kthr );
 
+/* statistics */
+#ifdef	SCHED_LATENCY
+static void kthread_latency ( kthread_t *kthread, ktime_t now );
+#endif
+
+/* processor reservations */
+static inline int kthread_background ( kthread_t *kthread );
+
+/* priority ordered queues */
+static int kthread_prio_cmp ( void *a, void *b );
+static void kthread_change_wait_prio ( kthread_t *kthread, int prio );
+
 /* idle thread */
 static void idle_thread ( void *param );
 
@@ -7,6 +7,7 @@
 #include <arch/time.h>
 #include <arch/interrupts.h>
 #include <kernel/thread.h>
+#include <kernel/sched.h>
 #include <kernel/memory.h>
 #include <kernel/kprint.h>
 #include <kernel/errno.h>
@@ -14,25 +15,40 @@
 #include <arch/processor.h>
 
 
-/*! List of active alarms */
-static list_t kalarms;
+/*! Active alarms */
+static ktwheel_t tw;
 
-static time_t threshold;
+static ktime_t threshold;
+
+/*! Scheduler timer (one-shot, not in alarm list) */
+static void (*sched_action) ( void * );
+static void *sched_param;
+
+/*! Frame timer (one-shot, for time-triggered schedule) */
+static void (*frame_action) ( void * );
+static void *frame_param;
 
 /*! Initialize time management subsystem */
 void k_time_init ()
 {
-	/* alarm list is empty */
-	list_init ( &kalarms );
+	int i, j;
 
-	arch_timer_init ();
+	/* timing wheel is empty */
+	for ( i = 0; i < TW_LEVELS; i++ )
+	{
+		for ( j = 0; j < TW_SLOTS; j++ )
+			list_init ( &tw.slot[i][j] );
+		tw.used[i] = 0;
+	}
+	list_init ( &tw.overflow );
+	tw.base = 0;
+
+	sched_action = NULL;
+	frame_action = NULL;
 
-	arch_get_min_interval ( &threshold );
+	arch_timer_init ();
 
-	threshold.nsec /= 2;
-	if ( threshold.sec % 2 )
-		threshold.nsec += 1000000000L / 2; /* + half second */
-	threshold.sec /= 2;
+	threshold = arch_get_min_interval () / 2;
 }
 
 /*! Called from interrupt handler when an alarm has expired */
@@ -42,87 +58,241 @@ static void k_timer_interrupt ()
 		kthreads_schedule ();
 }
 
+/*! Called from interrupt handler when scheduler timer has expired */
+static void k_sched_timer_interrupt ()
+{
+	void (*action) ( void * ) = sched_action;
+
+	sched_action = NULL;
+
+	if ( action )
+		action ( sched_param );
+}
+
+/*! Called from interrupt handler on frame boundary */
+static void k_frame_timer_interrupt ()
+{
+	void (*action) ( void * ) = frame_action;
+
+	frame_action = NULL;
+
+	if ( action )
+		action ( frame_param );
+}
+
 /*! Iterate through active alarms and activate newly expired ones */
 static int k_schedule_alarms ()
 {
 	kalarm_t *first;
-	time_t time, ref_time;
-	int resched_thr = 0;
-	kprocess_t *proc;
+	list_t *slot;
+	ktime_t ref_time;
+	uint64 now, start;
+	int level, s, resched_thr = 0;
 
-	arch_get_time ( &time );
-	ref_time = time;
-	time_add ( &ref_time, &threshold );
+	ref_time = arch_get_ktime () + threshold;
+	now = tw_tick ( ref_time );
 
 	/* should any alarm be activated? */
-	first = list_get ( &kalarms, FIRST );
-	while ( first != NULL )
+	while ( ( level = tw_first ( &s ) ) >= 0 || tw.base < now )
 	{
-		if ( time_cmp ( &first->alarm.exp_time, &ref_time ) <= 0 )
+		if ( level < 0 )
 		{
-			/* 'activate' alarm */
+			/* only overflow (if any) is left - move to present */
+			tw_advance ( now );
+			continue;
+		}
 
-			/* but first remove alarm from list */
-			first = list_remove ( &kalarms, FIRST, NULL );
+		start = tw_slot_start ( level, s );
+		if ( start > now )
+			break;
 
-			if ( first->alarm.flags & ALARM_PERIODIC )
-			{
-				/* calculate next activation time */
-				time_add ( &first->alarm.exp_time,
-					   &first->alarm.period );
-				/* put back into list */
-				list_sort_add ( &kalarms, first, &first->list,
-						alarm_cmp );
-			}
-			else {
-				first->active = 0;
-			}
+		tw_advance ( start );
+		slot = &tw.slot[level][s];
 
-			if ( first->alarm.action )
+		if ( level > 0 )
+		{
+			/* cascade alarms to lower levels */
+			while ( ( first = list_get ( slot, FIRST ) ) )
 			{
-				/* call directly:
-
-				first->alarm.action ( first->alarm.param );
-
-				   or create new thread for that job: */
-
-				if ( first->thread )
-				{ /* alarm scheduled by thread */
-				proc = kthread_get_process ( first->thread );
-				kthread_create (
-					first->alarm.action,
-					first->alarm.param,
-					proc->pi->exit,
-					0,
-					kthread_get_prio ( first->thread ) + 1,
-					NULL, 0, 1,
-					proc
-				);
-				resched_thr++;
-				}
-				else { /* alarm scheduled by kernel */
-				first->alarm.action ( first->alarm.param );
-				}
+				tw_remove ( first );
+				tw_insert ( first );
 			}
+			continue;
+		}
 
-			resched_thr += kthreadq_release_all ( &first->queue );
+		/* alarms in this tick which expire now (action may change
+		   alarms, so search is restarted after each one) */
+		first = list_get ( slot, FIRST );
+		while ( first && first->exp > ref_time )
+			first = list_get_next ( &first->list );
 
-			first = list_get ( &kalarms, FIRST );
+		if ( !first )
+		{
+			if ( list_get ( slot, FIRST ) )
+				break; /* rest expire later in this tick */
+			continue;
 		}
-		else {
+
+		/* 'activate' alarm */
+
+		/* but first remove alarm from wheel */
+		tw_remove ( first );
+
+		if ( first->alarm.flags & ALARM_PERIODIC )
+		{
+			/* calculate next activation time */
+			first->exp += first->period;
+			/* put back into wheel */
+			tw_insert ( first );
+		}
+
+		if ( first->alarm.action )
+		{
+			if ( first->proc )
+			{ /* alarm scheduled by thread: queue for dispatch */
+			resched_thr += k_alarm_dispatch ( first );
+			}
+			else { /* alarm scheduled by kernel: call directly */
+			first->alarm.action ( first->alarm.param );
+			}
+		}
+
+		resched_thr += kthreadq_release_all ( &first->queue );
+	}
+
+	k_alarm_timer_set ();
+
+	return resched_thr;
+}
+
+/*! Set timer for first active alarm (or cascade point before it) */
+static void k_alarm_timer_set ()
+{
+	kalarm_t *kalarm;
+	ktime_t exp_time;
+	int level, s;
+
+	level = tw_first ( &s );
+
+	if ( level == 0 )
+	{
+		/* earliest alarm in first tick */
+		kalarm = list_get ( &tw.slot[0][s], FIRST );
+		exp_time = kalarm->exp;
+		while ( ( kalarm = list_get_next ( &kalarm->list ) ) )
+			if ( kalarm->exp < exp_time )
+				exp_time = kalarm->exp;
+	}
+	else if ( level > 0 )
+	{
+		exp_time = tw_time ( tw_slot_start ( level, s ) );
+	}
+	else if ( list_get ( &tw.overflow, FIRST ) )
+	{
+		exp_time = tw_time ( ( ( tw.base >> ( TW_BITS * TW_LEVELS ) )
+				       + 1 ) << ( TW_BITS * TW_LEVELS ) );
+	}
+	else {
+		return;
+	}
+
+	arch_timer_set ( exp_time, k_timer_interrupt );
+}
+
+/*! Timing wheel -------------------------------------------------------------- */
+
+/*! Put active alarm in timing wheel */
+static void tw_insert ( kalarm_t *kalarm )
+{
+	uint64 tick = tw_tick ( kalarm->exp );
+	int level, s;
+
+	if ( tick < tw.base )
+		tick = tw.base; /* already expired */
+
+	for ( level = 0; level < TW_LEVELS; level++ )
+		if ( ( tick >> ( TW_BITS * ( level + 1 ) ) ) ==
+		     ( tw.base >> ( TW_BITS * ( level + 1 ) ) ) )
 			break;
+
+	if ( level < TW_LEVELS )
+	{
+		s = ( tick >> ( TW_BITS * level ) ) & TW_MASK;
+		kalarm->slot = &tw.slot[level][s];
+		tw.used[level] |= 1 << s;
+	}
+	else {
+		kalarm->slot = &tw.overflow;
+	}
+
+	kalarm->active = 1;
+	list_append ( kalarm->slot, kalarm, &kalarm->list );
+}
+
+/*! Remove active alarm from timing wheel */
+static void tw_remove ( kalarm_t *kalarm )
+{
+	int i;
+
+	list_remove ( kalarm->slot, FIRST, &kalarm->list );
+
+	if ( kalarm->slot != &tw.overflow && !list_get ( kalarm->slot, FIRST ) )
+	{
+		i = kalarm->slot - &tw.slot[0][0];
+		tw.used[i >> TW_BITS] &= ~( 1 << ( i & TW_MASK ) );
+	}
+
+	kalarm->active = 0;
+}
+
+/*! Find first non-empty slot: return its level (-1 if none) and index */
+static int tw_first ( int *slot )
+{
+	int level;
+
+	for ( level = 0; level < TW_LEVELS; level++ )
+	{
+		if ( tw.used[level] )
+		{
+			*slot = lsb_index ( tw.used[level] );
+			return level;
 		}
 	}
 
-	first = list_get ( &kalarms, FIRST );
-	if ( first )
+	return -1;
+}
+
+/*! First tick of given slot */
+static uint64 tw_slot_start ( int level, int slot )
+{
+	return ( ( tw.base >> ( TW_BITS * ( level + 1 ) ) ) <<
+		 ( TW_BITS * ( level + 1 ) ) ) |
+		( ( (uint64) slot ) << ( TW_BITS * level ) );
+}
+
+/*!
+ * Move wheel base forward (to start of first non-empty slot or, if wheel is
+ * empty, to present); when whole wheel is passed, overflow is checked again
+ */
+static void tw_advance ( uint64 tick )
+{
+	list_t overflow;
+	kalarm_t *kalarm;
+	int top = TW_BITS * TW_LEVELS;
+
+	if ( ( tick >> top ) == ( tw.base >> top ) )
 	{
-		ref_time = first->alarm.exp_time;
-		time_sub ( &ref_time, &time );
-		arch_timer_set ( &ref_time, k_timer_interrupt );
+		tw.base = tick;
+		return;
 	}
 
-	return resched_thr;
+	tw.base = tick;
+
+	overflow = tw.overflow;
+	list_init ( &tw.overflow );
+
+	while ( ( kalarm = list_remove ( &overflow, FIRST, NULL ) ) )
+		tw_insert ( kalarm );
 }
 
 /*!
@@ -134,10 +304,9 @@ static void k_alarm_add ( kalarm_t *kalarm )
 	int reschedule = 0;
 
 	/* if exp_time is given (>0) add it into active alarms */
-	if ( kalarm->alarm.exp_time.sec + kalarm->alarm.exp_time.nsec > 0 )
+	if ( kalarm->exp > 0 )
 	{
-		kalarm->active = 1;
-		list_sort_add ( &kalarms, kalarm, &kalarm->list, alarm_cmp );
+		tw_insert ( kalarm );
 	}
 	else {
 		kalarm->active = 0;
@@ -176,6 +345,8 @@ int k_alarm_new ( void **id, alarm_t *alarm, int priv )
 	ASSERT ( kalarm );
 
 	kalarm->alarm = *alarm; /* copy alarm data */
+	kalarm->exp = time_to_ktime ( &alarm->exp_time );
+	kalarm->period = time_to_ktime ( &alarm->period );
 	/* param checking is skipped - assuming all is OK */
 
 	kthreadq_init ( &kalarm->queue );
@@ -186,9 +357,15 @@ int k_alarm_new ( void **id, alarm_t *alarm, int priv )
 	*id = kalarm; /* return value = handler */
 
 	if ( priv == SYSCALL )
+	{
 		kalarm->thread = kthread_get_active ();
-	else /* priv == KERNELCALL */
+		kalarm->proc = kthread_get_process ( kalarm->thread );
+	}
+	else { /* priv == KERNELCALL */
 		kalarm->thread = NULL;
+		kalarm->proc = NULL;
+	}
+	kalarm->pending = 0;
 
 	k_alarm_add ( kalarm );
 
@@ -210,17 +387,19 @@ int k_alarm_set ( void *id, alarm_t *alarm )
 	kalarm->alarm.param = alarm->param;
 	kalarm->alarm.flags = alarm->flags;
 	kalarm->alarm.period = alarm->period;
+	kalarm->period = time_to_ktime ( &alarm->period );
 
 	SET_ERRNO ( SUCCESS );
 
 	/* is activation time changed? */
-	if ( time_cmp ( &kalarm->alarm.exp_time, &alarm->exp_time ) )
+	if ( kalarm->exp != time_to_ktime ( &alarm->exp_time ) )
 	{
 		/* remove from active alarms */
 		if ( kalarm->active )
-			list_remove ( &kalarms, FIRST, &kalarm->list );
+			tw_remove ( kalarm );
 
 		kalarm->alarm.exp_time = alarm->exp_time;
+		kalarm->exp = time_to_ktime ( &alarm->exp_time );
 
 		k_alarm_add ( kalarm );
 	}
@@ -236,6 +415,7 @@ int k_alarm_set ( void *id, alarm_t *alarm )
 int k_alarm_remove ( void *id )
 {
 	kalarm_t *kalarm;
+	kalarm_dispatch_t *dispatch;
 	int reschedule = 0;
 
 	kalarm = id;
@@ -244,7 +424,14 @@ int k_alarm_remove ( void *id )
 
 	/* remove from active alarms (if it was there) */
 	if ( kalarm->active )
-		list_remove ( &kalarms, FIRST, &kalarm->list );
+		tw_remove ( kalarm );
+
+	/* and from dispatch queue */
+	if ( kalarm->pending )
+	{
+		dispatch = ( (kprocess_t *) kalarm->proc )->alarm_dispatch;
+		list_remove ( &dispatch->pending, FIRST, &kalarm->pending_list );
+	}
 
 #ifdef DEBUG
 	kalarm->magic = 0;
@@ -265,6 +452,75 @@ int k_alarm_remove ( void *id )
 	RETURN ( SUCCESS );
 }
 
+/*!
+ * Set (or cancel) scheduler timer: single one-shot timer which doesn't go
+ * through alarm list (for time slices, budgets and similar, which are set on
+ * almost every thread switch); 'action' is always called from timer interrupt
+ * \param exp_time Expiration time (absolute, kernel time)
+ * \param action Function to call when timer expires (NULL to cancel timer)
+ * \param param Parameter for 'action'
+ */
+void k_sched_timer_set ( ktime_t exp_time, void *action, void *param )
+{
+	if ( !action )
+	{
+		sched_action = NULL;
+		arch_sched_timer_set ( 0, NULL );
+		return;
+	}
+
+	sched_action = action;
+	sched_param = param;
+
+	arch_sched_timer_set ( exp_time, k_sched_timer_interrupt );
+}
+
+/*!
+ * Set (or cancel) frame timer: it is separate from scheduler timer (which
+ * follows active thread) and from alarms, so frame boundaries are not delayed
+ * by them
+ * \param exp_time Absolute time of next frame boundary
+ * \param action Function to call then (NULL to cancel)
+ * \param param Parameter for 'action'
+ */
+void k_frame_timer_set ( ktime_t exp_time, void *action, void *param )
+{
+	if ( !action )
+	{
+		frame_action = NULL;
+		arch_frame_timer_set ( 0, NULL );
+		return;
+	}
+
+	frame_action = action;
+	frame_param = param;
+
+	arch_frame_timer_set ( exp_time, k_frame_timer_interrupt );
+}
+
+/*!
+ * Change expiration time of kernel alarm from within scheduler: unlike
+ * k_alarm_set, expired alarms are not processed here (nor is rescheduling
+ * done) - if new time already passed, timer interrupt is requested at once
+ * \param id Alarm
+ * \param exp_time New expiration time
+ */
+void k_alarm_rearm ( void *id, ktime_t exp_time )
+{
+	kalarm_t *kalarm = id;
+
+	ASSERT ( kalarm && kalarm->magic == ALARM_MAGIC );
+
+	if ( kalarm->active )
+		tw_remove ( kalarm );
+
+	/* ('alarm.exp_time' is converted from 'exp' only in sys__alarm_get) */
+	kalarm->exp = exp_time;
+	tw_insert ( kalarm );
+
+	k_alarm_timer_set ();
+}
+
 /*!
  * Get current time
  * \param time Pointer where to store time
@@ -274,6 +530,105 @@ void k_get_time ( time_t *time )
 	arch_get_time ( time );
 }
 
+/*!
+ * Get current time as kernel time (without conversion to seconds and
+ * nanoseconds, for schedulers which measure intervals on each switch)
+ * \return current time in nanoseconds
+ */
+ktime_t k_get_ktime ()
+{
+	return arch_get_ktime ();
+}
+
+/*!
+ * Queue expired alarm for its process dispatch thread (create it on first
+ * expiration in process)
+ * \param kalarm Expired alarm (set by thread)
+ * \return number of threads made ready
+ */
+static int k_alarm_dispatch ( kalarm_t *kalarm )
+{
+	kprocess_t *proc = kalarm->proc;
+	kalarm_dispatch_t *dispatch = proc->alarm_dispatch;
+	int ready = 0;
+
+	if ( !dispatch )
+	{
+		dispatch = kmalloc ( sizeof (kalarm_dispatch_t) );
+		ASSERT ( dispatch );
+
+		list_init ( &dispatch->pending );
+		kthreadq_init ( &dispatch->queue );
+		proc->alarm_dispatch = dispatch;
+
+		dispatch->thread = kthread_create ( proc->pi->alarm_dispatch,
+			NULL, proc->pi->exit, SCHED_SERVER,
+			kthread_get_prio ( kalarm->thread ) + 1,
+			NULL, 0, 1, proc );
+		ready++;
+	}
+
+	/* periodic alarm may expire again before its action is started */
+	if ( !kalarm->pending++ )
+		list_append ( &dispatch->pending, kalarm,
+			      &kalarm->pending_list );
+
+	/* action of lower priority owner may be running: it shouldn't delay
+	   this one (dispatch thread inherits priority of waiting owner) */
+	k_alarm_dispatch_prio ( dispatch, kthread_get_prio ( kalarm->thread ),
+				FALSE );
+
+	ready += kthreadq_release_all ( &dispatch->queue );
+
+	return ready;
+}
+
+/*!
+ * Set priority of dispatch thread above alarm owner with priority 'prio'
+ * \param dispatch Dispatch queue of process
+ * \param prio Owner priority
+ * \param lower Can priority be lowered (when new action is taken)?
+ */
+static void k_alarm_dispatch_prio ( kalarm_dispatch_t *dispatch, int prio,
+				    int lower )
+{
+	prio++;
+	if ( prio >= PRIO_LEVELS )
+		prio = PRIO_LEVELS - 1;
+
+	if ( prio > kthread_get_prio ( dispatch->thread ) ||
+	     ( lower && prio < kthread_get_prio ( dispatch->thread ) ) )
+		ksched_set_thread_prio ( dispatch->thread, prio );
+}
+
+/*!
+ * Thread in process with alarm dispatch thread is finished
+ * - if it was dispatch thread (canceled), pending actions are dropped
+ * - if only dispatch thread is left, wake it so it can complete pending
+ *   actions and exit
+ * \param proc Process
+ * \param kthread Finished thread
+ */
+void k_alarm_dispatch_thread_exit ( void *proc, void *kthread )
+{
+	kalarm_dispatch_t *dispatch = ( (kprocess_t *) proc )->alarm_dispatch;
+	kalarm_t *kalarm;
+
+	if ( dispatch->thread == kthread )
+	{
+		while ( ( kalarm = list_remove ( &dispatch->pending, FIRST,
+						 NULL ) ) )
+			kalarm->pending = 0;
+
+		( (kprocess_t *) proc )->alarm_dispatch = NULL;
+		kfree ( dispatch );
+	}
+	else if ( ( (kprocess_t *) proc )->thr_count == 1 )
+	{
+		kthreadq_release_all ( &dispatch->queue );
+	}
+}
+
 
 /*! Interface to threads ---------------------------------------------------- */
 
@@ -361,6 +716,7 @@ int sys__alarm_get ( void *p )
 				E_INVALID_HANDLE );
 
 	*alarm = kalarm->alarm;
+	ktime_to_time ( kalarm->exp, &alarm->exp_time );
 
 	EXIT ( SUCCESS );
 }
@@ -429,3 +785,72 @@ int sys__wait_for_alarm ( void *p )
 
 	return retval;
 }
+
+/*!
+ * Get next alarm action to run (for process alarm dispatch thread only)
+ * \param action Where to store function to call
+ * \param param Where to store parameter for 'action'
+ * \return 0 when action is returned; -E_RETRY when thread waited for expired
+ *	   alarm (and should call again); -E_CANCELED when it should exit
+ */
+int sys__alarm_dispatch ( void *p )
+{
+	void **action, **param;
+	kprocess_t *proc = kthread_get_process ( NULL );
+	kalarm_dispatch_t *dispatch = proc->alarm_dispatch;
+	kalarm_t *kalarm, *next;
+
+	action = *( (void **) p );	p += sizeof ( void *);
+	param = *( (void **) p );
+
+	ASSERT_ERRNO_AND_EXIT ( dispatch &&
+				dispatch->thread == kthread_get_active (),
+				E_NOT_OWNER );
+
+	action = U2K_GET_ADR ( action, proc );
+	param = U2K_GET_ADR ( param, proc );
+	ASSERT_ERRNO_AND_EXIT ( action && param, E_INVALID_HANDLE );
+
+	/* action of alarm with highest priority owner is run first */
+	kalarm = list_get ( &dispatch->pending, FIRST );
+	next = kalarm;
+	for ( ; next; next = list_get_next ( &next->pending_list ) )
+		if ( kthread_get_prio ( next->thread ) >
+		     kthread_get_prio ( kalarm->thread ) )
+			kalarm = next;
+
+	if ( kalarm )
+	{
+		if ( !--kalarm->pending )
+			list_remove ( &dispatch->pending, 0,
+				      &kalarm->pending_list );
+
+		*action = kalarm->alarm.action;
+		*param = kalarm->alarm.param;
+
+		SET_ERRNO ( SUCCESS );
+
+		/* action runs with priority above alarm owner (as before,
+		   when new thread was created for it) */
+		k_alarm_dispatch_prio ( dispatch,
+					kthread_get_prio ( kalarm->thread ),
+					TRUE );
+
+		RETURN ( SUCCESS );
+	}
+
+	if ( proc->thr_count == 1 )
+	{
+		/* no other threads in process - dispatch thread exits */
+		proc->alarm_dispatch = NULL;
+		kfree ( dispatch );
+
+		EXIT ( E_CANCELED );
+	}
+
+	SET_ERRNO ( E_RETRY );
+	kthread_enqueue ( NULL, &dispatch->queue );
+	kthreads_schedule ();
+
+	RETURN ( E_RETRY );
+}
@@ -9,17 +9,24 @@ int sys__alarm_set ( void *p );
 int sys__alarm_get ( void *p );
 int sys__alarm_remove ( void *p );
 int sys__wait_for_alarm ( void *p );
+int sys__alarm_dispatch ( void *p );
 
 #ifdef _KERNEL_
 
 #include <lib/types.h>
+#include <lib/ktime.h>
 
 /*! interface to kernel */
 void k_time_init ();
 int k_alarm_new ( void **id, alarm_t *alarm, int priv );
 int k_alarm_set ( void *id, alarm_t *alarm );
 int k_alarm_remove ( void *id );
+void k_sched_timer_set ( ktime_t exp_time, void *action, void *param );
+void k_frame_timer_set ( ktime_t exp_time, void *action, void *param );
+void k_alarm_rearm ( void *id, ktime_t exp_time );
 void k_get_time ( time_t *time );
+ktime_t k_get_ktime ();
+void k_alarm_dispatch_thread_exit ( void *proc, void *kthread );
 
 #endif /* _KERNEL_ */
 
@@ -28,45 +35,109 @@ void k_get_time ( time_t *time );
 #ifdef	_K_TIME_C_
 
 #include <lib/list.h>
+#include <lib/ktime.h>
 #include <kernel/thread.h>
 
 /*! Kernel alarm */
 typedef struct _kalarm_t_
 {
 	alarm_t alarm;	/* alarm data */
+	ktime_t exp;	/* 'alarm.exp_time' and 'alarm.period' in kernel format */
+	ktime_t period;	/* (alarm.exp_time isn't updated for periodic alarms) */
 
 	int active;	/* is alarm active (waiting) */
 
 	void *thread;	/* owner threads pointer */
+	void *proc;	/* owner process (for alarms set by threads) */
+
+	int pending;	/* expirations waiting for dispatch thread */
+	list_h pending_list;
 
 	kthread_q queue; /* which threads wait for this alarm? */
 
 #ifdef DEBUG
 	unsigned int magic;	/* alarm magic number - for error checking */
 #endif
-	list_h list;	/* active alarms are in list (in kernel) */
+	list_h list;	/* active alarms are in timing wheel slot lists */
+	list_t *slot;	/* in which slot (if active) */
 }
 kalarm_t;
 
 #define ALARM_MAGIC	0xD7422F8	/* alarm identifier (random number) */
 
+/*!
+ * Actions of alarms set by threads are run by single thread in process
+ * (created when first alarm expires), instead of new thread for each
+ * expiration. Expired alarms are queued in 'pending' (link is in alarm
+ * descriptor, so nothing is allocated on expiration); dispatch thread takes
+ * them with ALARM_DISPATCH syscall, waiting in 'queue' when there are none.
+ */
+typedef struct _kalarm_dispatch_t_
+{
+	kthread_t *thread;	/* dispatch thread */
+	list_t pending;		/* alarms with pending expirations */
+	kthread_q queue;	/* dispatch thread waits here */
+}
+kalarm_dispatch_t;
+
+/*!
+ * Hierarchical timing wheel for active alarms. Expiration time is converted
+ * to tick: tick is 2^20 ns (~1 ms), so conversion is single shift. Level 'L'
+ * has TW_SLOTS slots, each covering 2^(TW_BITS*L) ticks; alarm is put on
+ * lowest level on which its tick has same higher bits as 'base' (slot is
+ * selected with its tick bits for that level). Therefore all alarms on lower
+ * level expire before those on higher one and first non-empty slot is found
+ * with bit scans. When 'base' reaches slot on higher level, its alarms are
+ * moved (cascaded) to lower levels. Alarms beyond last level are kept in
+ * 'overflow' list, checked again when 'base' crosses 2^(TW_BITS*TW_LEVELS)
+ * ticks (~9.8 hours).
+ */
+#define TW_BITS		5
+#define TW_SLOTS	( 1 << TW_BITS )
+#define TW_MASK		( TW_SLOTS - 1 )
+#define TW_LEVELS	5
+
+#define TW_TICK_SHIFT	20	/* ns >> TW_TICK_SHIFT = tick */
+
+typedef struct _ktwheel_t_
+{
+	uint64 base;		/* all alarms in wheel expire at or after */
+	list_t slot[TW_LEVELS][TW_SLOTS];
+	uint32 used[TW_LEVELS];	/* bitmaps of non-empty slots */
+	list_t overflow;	/* alarms beyond last level */
+}
+ktwheel_t;
+
 /*! local functions */
 static void k_timer_interrupt ();
+static void k_sched_timer_interrupt ();
+static void k_frame_timer_interrupt ();
 static int k_schedule_alarms ();
 static void k_alarm_add ( kalarm_t *alarm );
+static void k_alarm_timer_set ();
+static int k_alarm_dispatch ( kalarm_t *kalarm );
+static void k_alarm_dispatch_prio ( kalarm_dispatch_t *dispatch, int prio,
+				    int lower );
+
+static void tw_insert ( kalarm_t *kalarm );
+static void tw_remove ( kalarm_t *kalarm );
+static int tw_first ( int *slot );
+static uint64 tw_slot_start ( int level, int slot );
+static void tw_advance ( uint64 tick );
+
+/*! Convert time to tick (times before zero are zero) */
+static inline uint64 tw_tick ( ktime_t t )
+{
+	if ( t < 0 )
+		return 0;
 
+	return t >> TW_TICK_SHIFT;
+}
 
-/*!
- * Compare alarms by expiration times (used when inserting new alarm in list)
- * \param a First alarm
- * \param b Second alarm
- * \return -1 when a < b, 0 when a == b, 1 when a > b
- */
-static inline int alarm_cmp ( void *_a, void *_b )
+/*! Convert tick to time (start of tick) */
+static inline ktime_t tw_time ( uint64 tick )
 {
-	kalarm_t *a = _a, *b = _b;
-
-	return time_cmp ( &a->alarm.exp_time, &b->alarm.exp_time );
+	return tick << TW_TICK_SHIFT;
 }
 
 #endif	/* _K_TIME_C_ */
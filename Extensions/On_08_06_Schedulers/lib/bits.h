@@ -22,10 +22,17 @@
 #define REQUIRE_MUL_DIV_32
 #endif
 
+#ifdef ARCH_DIV_64_32
+#define div_64_32	arch_div_64_32
+#else
+#define REQUIRE_DIV_64_32
+#endif
+
 /*! use generic implementations for unimplemented functions in arch layer */
 #if	defined(REQUIRE_MSB_INDEX) || \
 	defined(REQUIRE_LSB_INDEX) || \
-	defined(REQUIRE_MUL_DIV_32)
+	defined(REQUIRE_MUL_DIV_32) || \
+	defined(REQUIRE_DIV_64_32)
 
 #define REQUIRE_BITS_GENERIC
 
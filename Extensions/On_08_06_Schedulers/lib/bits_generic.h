@@ -36,6 +36,18 @@
 
 #endif
 
+#ifdef REQUIRE_DIV_64_32
+#define div_64_32	div_64_32_generic
+#endif
+
+/* 64-bit division (compiler may require library support for it) */
+static inline uint32 div_64_32_generic ( uint64 a, uint32 b, uint32 *rem )
+{
+	*rem = a % b;
+
+	return a / b;
+}
+
 /* All implementation assume num > 0 (functions don't check it) */
 
 /* optimized for 32-bit system */
@@ -0,0 +1,43 @@
+/*! Kernel internal time: nanoseconds in single 64-bit integer */
+
+#pragma once
+
+#include <lib/types.h>
+#include <lib/bits.h>
+
+/*
+ * 'time_t' (seconds and nanoseconds) is kept in interface to threads, while
+ * kernel timers use 'ktime_t', so adding, subtracting and comparing times are
+ * plain integer operations (without nanoseconds normalization). Conversion
+ * to 'time_t' requires division, so it is done only on interface.
+ */
+typedef int64 ktime_t;
+
+#define KTIME_SEC	1000000000LL	/* nanoseconds in second */
+
+/*! Convert time_t to ktime_t */
+static inline ktime_t time_to_ktime ( time_t *t )
+{
+	return (ktime_t) t->sec * KTIME_SEC + t->nsec;
+}
+
+/*! Compare times: -1 when a < b, 0 when a == b, 1 when a > b */
+static inline int ktime_cmp ( ktime_t a, ktime_t b )
+{
+	return a < b ? -1 : ( a > b ? 1 : 0 );
+}
+
+/*! Convert ktime_t to time_t (times before zero are zero) */
+static inline void ktime_to_time ( ktime_t kt, time_t *t )
+{
+	uint32 nsec;
+
+	if ( kt <= 0 )
+	{
+		t->sec = t->nsec = 0;
+		return;
+	}
+
+	t->sec = div_64_32 ( kt, KTIME_SEC, &nsec );
+	t->nsec = nsec;
+}
@@ -0,0 +1,270 @@
+/*! Balanced binary tree manipulation functions
+ *
+ * AVL tree: heights of left and right subtree of any element differ by at
+ * most one, so adding and removing elements is O(log n)
+ */
+
+#include "tree.h"
+
+#include <lib/types.h>
+#include ASSERT_H
+
+#define HEIGHT(T)	( (T) ? (T)->height : 0 )
+
+static void tree_set_height ( tree_h *hdr );
+static void tree_replace_child ( tree_t *tree, tree_h *parent,
+				 tree_h *old, tree_h *new );
+static tree_h *tree_rotate_left ( tree_t *tree, tree_h *x );
+static tree_h *tree_rotate_right ( tree_t *tree, tree_h *x );
+static void tree_rebalance ( tree_t *tree, tree_h *hdr );
+static tree_h *tree_successor ( tree_h *hdr );
+
+void tree_init ( tree_t *tree, int (*cmp) ( void *, void * ) )
+{
+	ASSERT ( tree && cmp );
+
+	tree->root = tree->first = NULL;
+	tree->cmp = cmp;
+}
+
+/*! Add element to tree */
+void tree_add ( tree_t *tree, void *object, tree_h *hdr )
+{
+	tree_h *iter, *parent = NULL;
+	int left = 0, first = 1;
+
+	ASSERT ( tree && object && hdr );
+
+	hdr->object = object; /* save reference to object */
+	hdr->left = hdr->right = NULL;
+	hdr->height = 1;
+
+	/* find place for new element (always a leaf) */
+	iter = tree->root;
+	while ( iter )
+	{
+		parent = iter;
+		left = tree->cmp ( object, iter->object ) < 0;
+		if ( left ) {
+			iter = iter->left;
+		}
+		else {
+			iter = iter->right;
+			first = 0;
+		}
+	}
+
+	hdr->parent = parent;
+
+	if ( !parent )
+		tree->root = hdr;
+	else if ( left )
+		parent->left = hdr;
+	else
+		parent->right = hdr;
+
+	if ( first )
+		tree->first = hdr;
+
+	tree_rebalance ( tree, parent );
+}
+
+/*! Get pointer to first (smallest) tree element */
+void *tree_get_first ( tree_t *tree )
+{
+	ASSERT ( tree );
+
+	if ( tree->first )
+		return tree->first->object;
+	else
+		return NULL;
+}
+
+/*! Get pointer to next object in tree (in sort order) */
+void *tree_get_next ( tree_h *hdr )
+{
+	hdr = tree_successor ( hdr );
+
+	if ( hdr )
+		return hdr->object;
+	else
+		return NULL;
+}
+
+/*!
+ * Remove element from tree
+ * \param tree	Tree identifier (pointer)
+ * \param ref	Reference (pointer) to element to be removed from tree; if
+ *		NULL first element is removed
+ * \return pointer to removed element, NULL if tree is empty
+ */
+void *tree_remove ( tree_t *tree, tree_h *ref )
+{
+	tree_h *hdr, *child, *next, *start;
+
+	ASSERT ( tree );
+
+	hdr = ref ? ref : tree->first;
+	if ( !hdr )
+		return NULL;
+
+	if ( tree->first == hdr )
+		tree->first = tree_successor ( hdr );
+
+	if ( hdr->left && hdr->right )
+	{
+		/* replace element with its successor (from right subtree) */
+		next = hdr->right;
+		while ( next->left )
+			next = next->left;
+
+		if ( next == hdr->right )
+		{
+			start = next;
+		}
+		else {
+			start = next->parent;
+
+			start->left = next->right;
+			if ( next->right )
+				next->right->parent = start;
+
+			next->right = hdr->right;
+			hdr->right->parent = next;
+		}
+
+		next->left = hdr->left;
+		hdr->left->parent = next;
+		next->height = hdr->height;
+
+		tree_replace_child ( tree, hdr->parent, hdr, next );
+	}
+	else {
+		child = hdr->left ? hdr->left : hdr->right;
+		start = hdr->parent;
+
+		tree_replace_child ( tree, hdr->parent, hdr, child );
+	}
+
+	tree_rebalance ( tree, start );
+
+	hdr->left = hdr->right = hdr->parent = NULL;
+
+	return hdr->object;
+}
+
+/*! Recalculate element height from its subtrees */
+static void tree_set_height ( tree_h *hdr )
+{
+	int l = HEIGHT ( hdr->left ), r = HEIGHT ( hdr->right );
+
+	hdr->height = ( l > r ? l : r ) + 1;
+}
+
+/*! Put 'new' in place of 'old' as 'parent' child (or as tree root) */
+static void tree_replace_child ( tree_t *tree, tree_h *parent,
+				 tree_h *old, tree_h *new )
+{
+	if ( !parent )
+		tree->root = new;
+	else if ( parent->left == old )
+		parent->left = new;
+	else
+		parent->right = new;
+
+	if ( new )
+		new->parent = parent;
+}
+
+/*! Rotate subtree starting with 'x' to the left; return new subtree root */
+static tree_h *tree_rotate_left ( tree_t *tree, tree_h *x )
+{
+	tree_h *y = x->right;
+
+	x->right = y->left;
+	if ( y->left )
+		y->left->parent = x;
+
+	tree_replace_child ( tree, x->parent, x, y );
+
+	y->left = x;
+	x->parent = y;
+
+	tree_set_height ( x );
+	tree_set_height ( y );
+
+	return y;
+}
+
+/*! Rotate subtree starting with 'x' to the right; return new subtree root */
+static tree_h *tree_rotate_right ( tree_t *tree, tree_h *x )
+{
+	tree_h *y = x->left;
+
+	x->left = y->right;
+	if ( y->right )
+		y->right->parent = x;
+
+	tree_replace_child ( tree, x->parent, x, y );
+
+	y->right = x;
+	x->parent = y;
+
+	tree_set_height ( x );
+	tree_set_height ( y );
+
+	return y;
+}
+
+/*! Restore heights and balance from 'hdr' up to tree root */
+static void tree_rebalance ( tree_t *tree, tree_h *hdr )
+{
+	int balance;
+
+	while ( hdr )
+	{
+		tree_set_height ( hdr );
+
+		balance = HEIGHT ( hdr->left ) - HEIGHT ( hdr->right );
+
+		if ( balance > 1 )
+		{
+			if ( HEIGHT ( hdr->left->left ) <
+			     HEIGHT ( hdr->left->right ) )
+				tree_rotate_left ( tree, hdr->left );
+
+			hdr = tree_rotate_right ( tree, hdr );
+		}
+		else if ( balance < -1 )
+		{
+			if ( HEIGHT ( hdr->right->right ) <
+			     HEIGHT ( hdr->right->left ) )
+				tree_rotate_right ( tree, hdr->right );
+
+			hdr = tree_rotate_left ( tree, hdr );
+		}
+
+		hdr = hdr->parent;
+	}
+}
+
+/*! Get next element (in sort order) */
+static tree_h *tree_successor ( tree_h *hdr )
+{
+	if ( !hdr )
+		return NULL;
+
+	if ( hdr->right )
+	{
+		hdr = hdr->right;
+		while ( hdr->left )
+			hdr = hdr->left;
+
+		return hdr;
+	}
+
+	while ( hdr->parent && hdr->parent->right == hdr )
+		hdr = hdr->parent;
+
+	return hdr->parent;
+}
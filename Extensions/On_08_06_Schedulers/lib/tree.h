@@ -0,0 +1,41 @@
+/*! Balanced binary tree manipulation functions
+ *
+ * AVL tree is used; tree header points to root and to first (smallest)
+ * element, so smallest element is retrieved in constant time
+ *
+ */
+
+#pragma once
+
+/*! Tree element pointers */
+typedef struct _tree_h_
+{
+	struct _tree_h_ *left;	 /* subtree with smaller elements */
+	struct _tree_h_ *right;	 /* subtree with greater (or equal) elements */
+	struct _tree_h_ *parent; /* parent tree element */
+	int height;		 /* height of subtree starting with element */
+	void *object;		 /* pointer to object start */
+}
+tree_h;
+
+/*! tree header type */
+typedef struct _tree_t_
+{
+	tree_h *root;
+	tree_h *first;		/* smallest element in tree */
+	int (*cmp) ( void *, void * ); /* compare function for objects */
+}
+tree_t;
+
+/*
+ As with lists (list.h), tree element must be included in object that we want
+ to put in tree. Elements are ordered by 'cmp' function given in 'tree_init';
+ elements which compare equal are kept in order of insertion (new element is
+ placed after existing equal ones).
+*/
+
+void tree_init ( tree_t *tree, int (*cmp) ( void *, void * ) );
+void tree_add ( tree_t *tree, void *object, tree_h *hdr );
+void *tree_get_first ( tree_t *tree );
+void *tree_get_next ( tree_h *hdr );
+void *tree_remove ( tree_t *tree, tree_h *ref );
@@ -94,6 +94,26 @@ typedef struct _thread_t_
 }
 thread_t;
 
+/*!
+ * Periodic thread: jobs are released at absolute times (creation time plus
+ * multiples of 'period'), so releases don't drift; job not completed (with
+ * wait_next_period) within 'deadline' after its release is overrun - it is
+ * counted and, if given, 'overrun_handler' is started as new thread (with
+ * same parameter as periodic thread)
+ */
+typedef struct _periodic_t_
+{
+	time_t period;
+	time_t deadline;	/* relative to release (zero: equals period) */
+	time_t wcet;		/* worst case execution time of job (if given,
+				   thread is created only if it passes
+				   admission test) */
+	void *overrun_handler;	/* (set only) */
+	uint jobs;		/* released jobs (get only) */
+	uint overruns;		/* jobs which missed deadline (get only) */
+}
+periodic_t;
+
 
 /*! Semaphore --------------------------------------------------------------- */
 typedef struct _sem_t_
@@ -151,7 +171,7 @@ static inline void time_add ( time_t *a, time_t *b )
 	a->sec = a->sec + b->sec;
 	a->nsec = a->nsec + b->nsec;
 
-	if ( a->nsec > 1000000000L )
+	if ( a->nsec >= 1000000000L )
 	{
 		a->sec++;
 		a->nsec -= 1000000000L;
@@ -213,6 +233,13 @@ static inline int time_cmp (time_t *a, time_t *b)
 enum {
 	SCHED_FIFO = 0,
 	SCHED_RR,
+	SCHED_EDF,
+	SCHED_CFS,
+	SCHED_MLFQ,
+	SCHED_STRIDE,
+	SCHED_SERVER,
+	SCHED_CYCLIC,
+	SCHED_IDLE,
 
 	SCHED_NUM
 };
@@ -223,17 +250,233 @@ enum {
  */
 
 /*!
- * RR scheduler, actualy do not need parameters to be set by user thread,
- * but is present for interface demonstration
+ * RR scheduler: time slice and threshold (when remaining part of interrupted
+ * slice is below threshold, thread is put at the end of its queue); per thread
+ * or as default for threads of given priority
  */
 typedef struct _sched_rr_t_
 {
-	time_t time_slice;
+	time_t time_slice;	/* if zero, default for thread priority is used */
+	time_t threshold;
+	int prio;		/* priority whose defaults are set/get; if zero,
+				   defaults for all priorities are set (global) */
 }
 sched_rr_t;
 
+/*! EDF scheduler, periodic threads with deadlines */
+typedef struct _sched_edf_t_
+{
+	time_t period;		/* period of job releases */
+	time_t deadline;	/* relative deadline (if zero, equals period) */
+	time_t wcet;		/* worst case execution time (if not zero,
+				   job is demoted when it exceeds it) */
+	int flags;		/* EDF_SET and/or EDF_WAIT */
+}
+sched_edf_t;
+
+/* EDF flags */
+#define EDF_SET		1	/* set thread parameters, start first job */
+#define EDF_WAIT	2	/* job is completed, wait for next period */
+
+/*! CFS scheduler, threads share processor proportionally to their weights */
+typedef struct _sched_cfs_t_
+{
+	time_t time_slice;	/* longest run before thread with smaller virtual
+				   runtime gets processor (global parameter) */
+	int weight;		/* thread weight, defined by its priority (get) */
+}
+sched_cfs_t;
+
+/*!
+ * MLFQ scheduler, thread which uses whole quantum is demoted to lower level
+ * (priority), thread which blocks early is promoted
+ */
+typedef struct _sched_mlfq_t_
+{
+	time_t time_slice;	/* quantum on highest level (global) or on
+				   thread current level (get) */
+	time_t boost_period;	/* all threads are periodically returned to
+				   their highest level (global parameter) */
+	int levels;		/* number of levels (global parameter) */
+	int level;		/* thread current level, 0 is highest (get) */
+}
+sched_mlfq_t;
+
+/*!
+ * Stride scheduler, threads share processor proportionally to their tickets;
+ * when process has its own tickets, they are divided among its threads in
+ * proportion to threads tickets (so process share doesn't depend on number
+ * of its threads)
+ */
+typedef struct _sched_stride_t_
+{
+	int tickets;		/* thread tickets (set if > 0) */
+	int proc_tickets;	/* thread process tickets (set if > 0; when
+				   zero, threads tickets are used directly) */
+	thread_t server;	/* thread to receive tickets while this thread
+				   is blocked on message or semaphore */
+	int flags;		/* STRIDE_SERVER: set (or clear) 'server' */
+	time_t time_slice;	/* global parameter */
+}
+sched_stride_t;
+
+#define STRIDE_SERVER	1
+
+/*!
+ * Bandwidth server for aperiodic threads (signal handlers, alarm actions):
+ * all server threads together may use 'budget' of processor time in each
+ * 'period' with their priorities; then they run only in background (with
+ * 'prio_low') until budget is replenished
+ */
+typedef struct _sched_server_t_
+{
+	time_t budget;		/* zero budget - no limit (global parameter) */
+	time_t period;		/* global parameter */
+	int prio_low;		/* global parameter */
+	time_t remaining;	/* budget remaining in current period (get) */
+}
+sched_server_t;
+
+/*!
+ * Cyclic executive (time-triggered schedule): major frame of 'frames' minor
+ * frames, each 'minor' long, is repeated forever; in it threads run only in
+ * slots given by schedule table, e.g. thread A in first 2 ms of every minor
+ * frame and thread B from 2 to 5 ms of first minor frame
+ */
+typedef struct _cyclic_slot_t_
+{
+	thread_t thread;	/* thread running in slot (must be SCHED_CYCLIC) */
+	int frame;		/* minor frame index (0 .. frames - 1) */
+	time_t offset;		/* slot start, from minor frame start */
+	time_t length;		/* slot duration */
+}
+cyclic_slot_t;
+
+#define CYCLIC_MAX_SLOTS	64
+
+typedef struct _sched_cyclic_t_
+{
+	time_t minor;		/* minor frame length (global parameter) */
+	int frames;		/* minor frames in major frame (global) */
+	cyclic_slot_t *table;	/* slots ordered by frame and offset (set only;
+				   table is copied into kernel) */
+	int slots;		/* slots in 'table'; zero stops schedule */
+	int frame;		/* minor frame of current or next slot (get) */
+}
+sched_cyclic_t;
+
 typedef union _sched_t_
 {
 	sched_rr_t rr;
+	sched_edf_t edf;
+	sched_cfs_t cfs;
+	sched_mlfq_t mlfq;
+	sched_stride_t stride;
+	sched_server_t server;
+	sched_cyclic_t cyclic;
+}
+sched_t;
+
+/*!
+ * Threads statistics ("sysinfo threads"): threads_info_t is followed by
+ * 'threads' thread_info_t and then by 'processes' process_info_t elements
+ */
+typedef struct _threads_info_t_
+{
+	int threads;		/* number of thread_info_t elements */
+	int processes;		/* number of process_info_t elements */
+	time_t time;		/* when statistics was collected */
+}
+threads_info_t;
+
+typedef struct _thread_info_t_
+{
+	uint id;		/* thread id */
+	uint proc_id;		/* process id (0 for kernel threads) */
+	int prio;
+	int sched_policy;
+	int state;		/* 1-active, 2-ready, 3-blocked, 4-finished */
+	int cpu;		/* processor thread was last active on */
+
+	time_t run_time;	/* processor time used */
+	time_t last_run;	/* when thread was last activated/deactivated */
+	uint voluntary;		/* switches when thread blocked (or exited) */
+	uint involuntary;	/* switches when thread was preempted */
 }
-sched_t;
\ No newline at end of file
+thread_info_t;
+
+typedef struct _process_info_t_
+{
+	uint id;		/* process id (0 for kernel) */
+	int threads;		/* number of (unfinished) threads */
+
+	time_t run_time;	/* sum for all its threads, even finished ones */
+	uint voluntary;
+	uint involuntary;
+}
+process_info_t;
+
+/*!
+ * Scheduler latency (from thread becoming ready until it becomes active)
+ * histogram; bucket 0 counts latencies below 1 us, bucket 'i' ones in
+ * [2^(i-1), 2^i) us, while last bucket counts all longer ones
+ */
+#define LAT_BUCKETS	24
+
+typedef struct _sched_lat_t_
+{
+	uint count[LAT_BUCKETS];
+	uint samples;		/* sum of all buckets */
+	uint max;		/* longest latency [us] */
+}
+sched_lat_t;
+
+/* histograms are kept per priority and per scheduling policy */
+#define LAT_PRIO	0
+#define LAT_POLICY	1
+
+/*!
+ * Real-time throttling: threads with priority 'prio' or higher may together
+ * use at most 'runtime' of processor time in each 'period' (e.g. 950 ms per
+ * 1 s), leaving the rest to lower priority threads; zero 'runtime' disables
+ * limit. With RT_THROTTLE_PROC only 'runtime' is used, as limit for real-time
+ * threads of calling process (within same periods).
+ */
+typedef struct _rt_throttle_t_
+{
+	int prio;
+	time_t runtime;
+	time_t period;
+	int flags;
+}
+rt_throttle_t;
+
+#define RT_THROTTLE_PROC	1
+
+/*!
+ * Processor reservation of process: all its threads together may use at most
+ * 'budget' of processor time in each 'period' (zero 'budget': no limit), so
+ * process with many threads doesn't get more than process with few. When
+ * budget is used up, process threads wait for next period or, with
+ * RESERVE_DEMOTE, run only when no other thread is ready.
+ */
+typedef struct _cpu_reserve_t_
+{
+	time_t budget;
+	time_t period;
+	int flags;
+	time_t used;		/* used in current period (get only) */
+}
+cpu_reserve_t;
+
+#define RESERVE_DEMOTE	1
+
+/*!
+ * Preemption deferral hint: word in thread memory registered with
+ * set_preempt_hint; thread sets PREEMPT_DEFER while in short critical section
+ * (e.g. holding spin lock) and Round Robin scheduler, instead of preempting it
+ * on slice expiry, gives it short extension once and sets PREEMPT_YIELD;
+ * thread should then yield when leaving critical section
+ */
+#define PREEMPT_DEFER	1	/* set/cleared by thread */
+#define PREEMPT_YIELD	2	/* set by kernel when extension was given */
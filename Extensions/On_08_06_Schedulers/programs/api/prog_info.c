@@ -3,6 +3,7 @@
 #include "prog_info.h"
 #include <api/thread.h>
 #include <api/malloc.h>
+#include <api/time.h>
 
 /* symbols from user.ld */
 extern char user_code, user_end;
@@ -17,6 +18,7 @@ prog_info_t pi =
 	.entry =	PROG_START_FUNC,
 	.param =	NULL,
 	.exit =		thread_exit,
+	.alarm_dispatch = alarm_dispatch,
 	.prio =		THR_DEFAULT_PRIO,
 
 	.heap_size =	HEAP_SIZE,
@@ -12,6 +12,7 @@ typedef struct _prog_info_t_
 	void *entry;	/* starting user function */
 	void *param;	/* parameter to starting function */
 	void *exit;	/* terminating function */
+	void *alarm_dispatch; /* thread function running alarm actions */
 	uint prio;
 
 	size_t heap_size;
@@ -55,16 +55,163 @@ int start_program ( char *prog_name, thread_t *handle, void *param,
 	return syscall ( START_PROGRAM, prog_name, handle, param, sched, prio );
 }
 
+/*!
+ * Create periodic thread
+ * \param start_func Thread function; after each job it calls wait_next_period
+ * \param param Parameter for 'start_func' and 'overrun_handler'
+ * \param sched Scheduling policy
+ * \param prio Priority
+ * \param period Period of job releases (first job is released immediately)
+ * \param deadline Relative deadline (if NULL or zero, equals period)
+ * \param wcet Worst case execution time of job (if given, thread is created
+ *        only if real-time threads stay schedulable)
+ * \param overrun_handler Function started as new thread when job misses its
+ *        deadline (may be NULL)
+ * \param handle Thread descriptor
+ */
+int create_periodic_thread ( void *start_func, void *param, int sched,
+			     int prio, time_t *period, time_t *deadline,
+			     time_t *wcet, void *overrun_handler,
+			     thread_t *handle )
+{
+	periodic_t periodic;
+
+	ASSERT_ERRNO_AND_RETURN ( start_func && period, E_INVALID_ARGUMENT );
+
+	periodic.period = *period;
+	if ( deadline )
+		periodic.deadline = *deadline;
+	else
+		periodic.deadline.sec = periodic.deadline.nsec = 0;
+	if ( wcet )
+		periodic.wcet = *wcet;
+	else
+		periodic.wcet.sec = periodic.wcet.nsec = 0;
+	periodic.overrun_handler = overrun_handler;
+
+	return syscall ( CREATE_PERIODIC_THREAD, start_func, param, sched, prio,
+			 &periodic, handle );
+}
+
+/*! Job is completed - wait for release of next one */
+int wait_next_period ()
+{
+	return syscall ( WAIT_NEXT_PERIOD );
+}
+
+/*! Get periodic thread parameters and number of jobs and overruns */
+int get_periodic_info ( thread_t *thread, periodic_t *info )
+{
+	ASSERT_ERRNO_AND_RETURN ( thread && info, E_INVALID_ARGUMENT );
+	return syscall ( GET_PERIODIC_INFO, thread, info );
+}
+
 /*! Set thread scheduling parameters */
 int set_sched_params ( thread_t *thread, int sched_policy, int prio,
 		       sched_t *params )
 {
-	return syscall ( SET_SCHED_PARAMS, thread, sched_policy, prio, params );
+	return syscall ( SET_THREAD_SCHED_PARAMS, thread, sched_policy, prio, params );
 }
 
 /*! Get thread scheduling parameters */
 int get_sched_params ( thread_t *thread, int *sched_policy, int *prio,
 		       sched_t *params )
 {
-	return syscall ( GET_SCHED_PARAMS, thread, sched_policy, prio, params );
+	return syscall ( GET_THREAD_SCHED_PARAMS, thread, sched_policy, prio, params );
+}
+
+/*! Set scheduler (global) parameters */
+int set_policy_params ( int sched_policy, sched_t *params )
+{
+	return syscall ( SET_SCHED_PARAMS, sched_policy, params );
+}
+
+/*! Get scheduler (global) parameters */
+int get_policy_params ( int sched_policy, sched_t *params )
+{
+	return syscall ( GET_SCHED_PARAMS, sched_policy, params );
+}
+
+/*!
+ * Get scheduler latency histogram
+ * \param type LAT_PRIO or LAT_POLICY
+ * \param index Priority or scheduling policy
+ * \param lat Where to store histogram
+ * \param reset Clear histogram after it is read?
+ */
+int get_sched_latency ( int type, int index, sched_lat_t *lat, int reset )
+{
+	return syscall ( GET_SCHED_LATENCY, type, index, lat, reset );
+}
+
+/*!
+ * Set limit for real-time threads (globally or for calling process)
+ * \param params Priority, runtime and period (see rt_throttle_t)
+ */
+int set_rt_throttle ( rt_throttle_t *params )
+{
+	return syscall ( SET_RT_THROTTLE, params );
+}
+
+/*!
+ * Get limit for real-time threads
+ * \param params Where to store limit (with RT_THROTTLE_PROC in 'flags' for
+ *        limit of calling process)
+ */
+int get_rt_throttle ( rt_throttle_t *params )
+{
+	return syscall ( GET_RT_THROTTLE, params );
+}
+
+/*!
+ * Set processor reservation for process
+ * \param thread Any thread of that process (NULL for calling process)
+ * \param params Budget, period and flags (see cpu_reserve_t)
+ */
+int set_cpu_reserve ( thread_t *thread, cpu_reserve_t *params )
+{
+	ASSERT_ERRNO_AND_RETURN ( params, E_INVALID_ARGUMENT );
+	return syscall ( SET_CPU_RESERVE, thread, params );
+}
+
+/*!
+ * Get processor reservation of process
+ * \param thread Any thread of that process (NULL for calling process)
+ * \param params Where to store reservation (and time used in period)
+ */
+int get_cpu_reserve ( thread_t *thread, cpu_reserve_t *params )
+{
+	ASSERT_ERRNO_AND_RETURN ( params, E_INVALID_ARGUMENT );
+	return syscall ( GET_CPU_RESERVE, thread, params );
+}
+
+/*!
+ * Register preemption deferral hint word for calling thread
+ * \param hint Thread's word (must stay valid while registered); NULL clears
+ */
+int set_preempt_hint ( volatile int *hint )
+{
+	return syscall ( SET_PREEMPT_HINT, hint );
+}
+
+/*! Give processor to other ready threads with same priority */
+int thread_yield ()
+{
+	return syscall ( THREAD_YIELD );
+}
+
+/*! Entering short critical section: ask not to be preempted on slice end */
+void preempt_defer_begin ( volatile int *hint )
+{
+	*hint |= PREEMPT_DEFER;
+}
+
+/*! Leaving critical section: yield if extension was given meanwhile */
+void preempt_defer_end ( volatile int *hint )
+{
+	/* once PREEMPT_DEFER is cleared, kernel won't set PREEMPT_YIELD */
+	*hint &= ~PREEMPT_DEFER;
+
+	if ( *hint & PREEMPT_YIELD )
+		thread_yield ();
 }
@@ -14,7 +14,30 @@ int thread_self ( thread_t *thr );
 int start_program ( char *prog_name, thread_t *handle, void *param,
 		    int sched, int prio );
 
+int create_periodic_thread ( void *start_func, void *param, int sched,
+			     int prio, time_t *period, time_t *deadline,
+			     time_t *wcet, void *overrun_handler,
+			     thread_t *handle );
+int wait_next_period ();
+int get_periodic_info ( thread_t *thread, periodic_t *info );
+
 int set_sched_params ( thread_t *thread, int sched_policy, int prio,
 		       sched_t *params );
 int get_sched_params ( thread_t *thread, int *sched_policy, int *prio,
 		       sched_t *params );
+
+int set_policy_params ( int sched_policy, sched_t *params );
+int get_policy_params ( int sched_policy, sched_t *params );
+
+int get_sched_latency ( int type, int index, sched_lat_t *lat, int reset );
+
+int set_rt_throttle ( rt_throttle_t *params );
+int get_rt_throttle ( rt_throttle_t *params );
+
+int set_cpu_reserve ( thread_t *thread, cpu_reserve_t *params );
+int get_cpu_reserve ( thread_t *thread, cpu_reserve_t *params );
+
+int set_preempt_hint ( volatile int *hint );
+int thread_yield ();
+void preempt_defer_begin ( volatile int *hint );
+void preempt_defer_end ( volatile int *hint );
@@ -5,6 +5,7 @@
 #include <lib/types.h>
 #include <api/stdio.h>
 #include <api/errno.h>
+#include <api/thread.h>
 
 /*!
  * Get current system time
@@ -109,7 +110,7 @@ int delay ( time_t *t )
 
 	aps.sec += t->sec;
 	aps.nsec += t->nsec;
-	if ( aps.nsec > 1000000000 )
+	if ( aps.nsec >= 1000000000 )
 	{
 		aps.nsec -= 1000000000;
 		aps.sec++;
@@ -140,3 +141,25 @@ int wait_for_alarm ( void *id, int wait )
 	ASSERT_ERRNO_AND_RETURN ( id, E_INVALID_ARGUMENT );
 	return syscall ( WAIT_FOR_ALARM, id, wait );
 }
+
+/*!
+ * Alarm dispatch thread (created by kernel when first alarm of process
+ * expires): runs actions of expired alarms, one after other; it is stopped
+ * when other process threads are finished
+ */
+void alarm_dispatch ( void *p )
+{
+	void (*action) ( void * );
+	void *param;
+	int retval;
+
+	do {
+		retval = syscall ( ALARM_DISPATCH, &action, &param );
+
+		if ( !retval && action )
+			action ( param );
+	}
+	while ( retval != -E_CANCELED );
+
+	thread_exit ( 0 );
+}
@@ -18,3 +18,5 @@ int time_get ( time_t *t );
 int alarm_remove ( void *id );
 
 int wait_for_alarm ( void *id, int wait );
+
+void alarm_dispatch ( void *p );
@@ -0,0 +1,75 @@
+/*! Completely Fair Scheduler test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "CFS demonstration example: create several threads with "
+		   "different weights and count their iterations.";
+
+#define THR_NUM	4
+#define INNER_LOOP_COUNT 10000
+#define TEST_DURATION	5 /* seconds */
+
+static int iterations[THR_NUM];
+static int weight[THR_NUM];
+
+/* thread priorities (with CFS they define thread weights) */
+static int prio[THR_NUM] = {
+	THR_DEFAULT_PRIO, THR_DEFAULT_PRIO, THR_DEFAULT_PRIO + 2,
+	THR_DEFAULT_PRIO - 2
+};
+
+/* example thread */
+static void cfs_thread ( void *param )
+{
+	int j, thr_no;
+
+	thr_no = (int) param;
+
+	print ( "CFS thread %d starting (prio=%d)\n", thr_no, prio[thr_no] );
+
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		iterations[thr_no]++;
+	}
+}
+
+int cfs ( char *args[] )
+{
+	thread_t thread[THR_NUM];
+	int i;
+	time_t sleep;
+	sched_t params;
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		iterations[i] = 0;
+		create_thread ( cfs_thread, (void *) i,
+				SCHED_CFS, prio[i], &thread[i] );
+	}
+
+	print ( "Threads created, giving them %d seconds\n", TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+	print ( "Test over - threads are to be canceled\n");
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		get_sched_params ( &thread[i], NULL, NULL, &params );
+		weight[i] = params.cfs.weight;
+		cancel_thread ( &thread[i] );
+	}
+	for ( i = 0; i < THR_NUM; i++ )
+		wait_for_thread ( &thread[i], IPC_WAIT );
+	for ( i = 0; i < THR_NUM; i++ )
+		print ( "Thread %d (prio=%d, weight=%d), iterations=%d\n", i,
+			prio[i], weight[i], iterations[i] );
+
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*! Cyclic executive scheduler test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "Cyclic executive demonstration example: threads run only "
+		   "in their slots of static schedule table; count their "
+		   "iterations.";
+
+#define THR_NUM	3
+#define INNER_LOOP_COUNT 10000
+#define TEST_DURATION	3 /* seconds */
+
+#define MINOR_FRAME	10000000 /* 10 ms */
+#define FRAMES		4
+
+static int iterations[THR_NUM];
+
+/* example thread */
+static void cyclic_thread ( void *param )
+{
+	int j, thr_no;
+
+	thr_no = (int) param;
+
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		iterations[thr_no]++;
+	}
+}
+
+/* append slot to schedule table (times in ms) */
+static void add_slot ( cyclic_slot_t *table, int *slots, thread_t *thread,
+		       int frame, int offset, int length )
+{
+	table[*slots].thread = *thread;
+	table[*slots].frame = frame;
+	table[*slots].offset.sec = 0;
+	table[*slots].offset.nsec = offset * 1000000;
+	table[*slots].length.sec = 0;
+	table[*slots].length.nsec = length * 1000000;
+	(*slots)++;
+}
+
+int cyclic ( char *args[] )
+{
+	thread_t thread[THR_NUM];
+	cyclic_slot_t table[2 * FRAMES];
+	int i, slots;
+	time_t sleep;
+	sched_t params;
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		iterations[i] = 0;
+		create_thread ( cyclic_thread, (void *) i, SCHED_CYCLIC,
+				THR_DEFAULT_PRIO, &thread[i] );
+	}
+
+	/*
+	 * thread 0: first 2 ms of every minor frame (8 ms per major frame)
+	 * thread 1: 2-6 ms of frames 0 and 2 (8 ms per major frame)
+	 * thread 2: 2-8 ms of frame 1 (6 ms per major frame)
+	 */
+	slots = 0;
+	for ( i = 0; i < FRAMES; i++ )
+	{
+		add_slot ( table, &slots, &thread[0], i, 0, 2 );
+
+		if ( i == 0 || i == 2 )
+			add_slot ( table, &slots, &thread[1], i, 2, 4 );
+		else if ( i == 1 )
+			add_slot ( table, &slots, &thread[2], i, 2, 6 );
+	}
+
+	params.cyclic.minor.sec = 0;
+	params.cyclic.minor.nsec = MINOR_FRAME;
+	params.cyclic.frames = FRAMES;
+	params.cyclic.table = table;
+	params.cyclic.slots = slots;
+
+	if ( set_policy_params ( SCHED_CYCLIC, &params ) )
+	{
+		print ( "Schedule table rejected!\n" );
+		return -1;
+	}
+
+	print ( "Schedule table set, running it for %d seconds\n",
+		TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+
+	params.cyclic.slots = 0;
+	set_policy_params ( SCHED_CYCLIC, &params );
+
+	print ( "Test over - threads are to be canceled\n");
+
+	for ( i = 0; i < THR_NUM; i++ )
+		cancel_thread ( &thread[i] );
+	for ( i = 0; i < THR_NUM; i++ )
+		wait_for_thread ( &thread[i], IPC_WAIT );
+	for ( i = 0; i < THR_NUM; i++ )
+		print ( "Thread %d, iterations=%d\n", i, iterations[i] );
+	print ( "(expected ratio 8 : 8 : 6)\n" );
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*! Earliest Deadline First scheduling test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "EDF demonstration example: create several periodic threads "
+		   "and count their jobs.";
+
+#define THR_NUM	3
+#define INNER_LOOP_COUNT 10000
+#define TEST_DURATION	5 /* seconds */
+
+static int jobs[THR_NUM];
+
+/* periods of threads in milliseconds (deadline = period) */
+static int period_ms[THR_NUM] = { 100, 150, 350 };
+
+/* example periodic threads */
+static void edf_thread ( void *param )
+{
+	int j, thr_no;
+	thread_t self;
+	sched_t params;
+
+	thr_no = (int) param;
+	thread_self ( &self );
+
+	params.edf.period.sec = 0;
+	params.edf.period.nsec = period_ms[thr_no] * 1000000;
+	params.edf.deadline = params.edf.period;
+	params.edf.wcet.sec = params.edf.wcet.nsec = 0;
+	params.edf.flags = EDF_SET;
+
+	set_sched_params ( &self, SCHED_EDF, 0, &params );
+
+	print ( "EDF thread %d starting (period=%d ms)\n", thr_no,
+		period_ms[thr_no] );
+
+	params.edf.flags = EDF_WAIT;
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		jobs[thr_no]++;
+
+		set_sched_params ( &self, SCHED_EDF, 0, &params );
+	}
+}
+
+int edf ( char *args[] )
+{
+	thread_t thread[THR_NUM];
+	int i;
+	time_t sleep;
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		jobs[i] = 0;
+		create_thread ( edf_thread, (void *) i,
+				SCHED_EDF, THR_DEFAULT_PRIO + 1, &thread[i] );
+	}
+
+	print ( "Threads created, giving them %d seconds\n", TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+	print ( "Test over - threads are to be canceled\n");
+
+	for ( i = 0; i < THR_NUM; i++ )
+		cancel_thread ( &thread[i] );
+	for ( i = 0; i < THR_NUM; i++ )
+		wait_for_thread ( &thread[i], IPC_WAIT );
+	for ( i = 0; i < THR_NUM; i++ )
+		print ( "Thread %d (period=%d ms), jobs=%d\n", i,
+			period_ms[i], jobs[i] );
+
+	return 0;
+}
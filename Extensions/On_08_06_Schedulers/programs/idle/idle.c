@@ -0,0 +1,83 @@
+/*! Idle scheduling class test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "Idle scheduling class demonstration example: background "
+		   "thread uses only processor time foreground thread leaves.";
+
+#define INNER_LOOP_COUNT 10000
+#define WORK_LOOPS	100
+#define TEST_DURATION	5 /* seconds */
+
+static int background_iters, foreground_jobs;
+
+/* background (housekeeping) thread - runs only when processor is idle */
+static void background_thread ( void *param )
+{
+	int j;
+
+	print ( "Background thread starting\n" );
+
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		background_iters++;
+	}
+}
+
+/* foreground thread - short bursts of work, then sleeps */
+static void foreground_thread ( void *param )
+{
+	int i, j;
+	time_t sleep;
+
+	print ( "Foreground thread starting\n" );
+
+	sleep.sec = 0;
+	sleep.nsec = 100000000;
+
+	while (1)
+	{
+		for ( i = 0; i < WORK_LOOPS; i++ )
+			for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+				memory_barrier ();
+
+		foreground_jobs++;
+
+		delay ( &sleep );
+	}
+}
+
+int idle ( char *args[] )
+{
+	thread_t background, foreground;
+	time_t sleep;
+
+	background_iters = foreground_jobs = 0;
+
+	/* (background thread is created with high priority - it is ignored) */
+	create_thread ( background_thread, NULL, SCHED_IDLE,
+			THR_DEFAULT_PRIO + 1, &background );
+	create_thread ( foreground_thread, NULL, SCHED_FIFO,
+			THR_DEFAULT_PRIO - 1, &foreground );
+
+	print ( "Threads created, giving them %d seconds\n", TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+
+	cancel_thread ( &background );
+	cancel_thread ( &foreground );
+	wait_for_thread ( &background, IPC_WAIT );
+	wait_for_thread ( &foreground, IPC_WAIT );
+
+	print ( "Foreground jobs=%d, background iterations=%d\n",
+		foreground_jobs, background_iters );
+
+	return 0;
+}
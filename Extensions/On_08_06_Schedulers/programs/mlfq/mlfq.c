@@ -0,0 +1,96 @@
+/*! Multi-level feedback queue scheduler test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "MLFQ demonstration example: CPU bound threads are demoted "
+		   "while interactive thread (which mostly sleeps) stays on "
+		   "highest level.";
+
+#define THR_NUM	4	/* first is interactive, others are CPU bound */
+#define INNER_LOOP_COUNT 10000
+#define TEST_DURATION	5 /* seconds */
+#define SLEEP_MS	10
+
+static int iterations[THR_NUM];
+static int max_delay; /* longest interactive thread wakeup delay [us] */
+
+/* interactive thread: sleeps and measures how late it wakes up */
+static void interactive_thread ( void *param )
+{
+	time_t sleep, t1, t2;
+	int late;
+
+	sleep.sec = 0;
+	sleep.nsec = SLEEP_MS * 1000000;
+
+	while (1)
+	{
+		time_get ( &t1 );
+		delay ( &sleep );
+		time_get ( &t2 );
+
+		late = ( t2.sec - t1.sec ) * 1000000 +
+		       ( t2.nsec - t1.nsec ) / 1000 - SLEEP_MS * 1000;
+		if ( late > max_delay )
+			max_delay = late;
+
+		iterations[0]++;
+	}
+}
+
+/* CPU bound thread */
+static void cpu_thread ( void *param )
+{
+	int j, thr_no;
+
+	thr_no = (int) param;
+
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		iterations[thr_no]++;
+	}
+}
+
+int mlfq ( char *args[] )
+{
+	thread_t thread[THR_NUM];
+	int i;
+	time_t sleep;
+	sched_t params;
+
+	max_delay = 0;
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		iterations[i] = 0;
+		create_thread ( i ? cpu_thread : interactive_thread,
+				(void *) i, SCHED_MLFQ, THR_DEFAULT_PRIO,
+				&thread[i] );
+	}
+
+	print ( "Threads created, giving them %d seconds\n", TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+	print ( "Test over - threads are to be canceled\n");
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		get_sched_params ( &thread[i], NULL, NULL, &params );
+		cancel_thread ( &thread[i] );
+		print ( "Thread %d (%s) level=%d, iterations=%d\n", i,
+			i ? "cpu bound" : "interactive", params.mlfq.level,
+			iterations[i] );
+	}
+	for ( i = 0; i < THR_NUM; i++ )
+		wait_for_thread ( &thread[i], IPC_WAIT );
+
+	print ( "Interactive thread longest wakeup delay: %d us\n", max_delay );
+
+	return 0;
+}
@@ -0,0 +1,116 @@
+/*! Periodic threads test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "Periodic threads demonstration example: create periodic "
+		   "threads, one of which sometimes misses its deadline, and "
+		   "count jobs and overruns.";
+
+#define THR_NUM	2
+#define TEST_DURATION	3 /* seconds */
+
+/* periods, deadlines and execution times of jobs, in milliseconds */
+static int period_ms[THR_NUM] =		{ 50, 100 };
+static int deadline_ms[THR_NUM] =	{ 50, 20 };
+static int exec_ms[THR_NUM] =		{ 5, 15 };
+static int wcet_ms[THR_NUM] =		{ 5, 0 }; /* second isn't tested */
+
+static int handled[THR_NUM];
+
+/* busy loop for given time */
+static void work ( int ms )
+{
+	time_t start, now;
+
+	time_get ( &start );
+	do {
+		memory_barrier ();
+		time_get ( &now );
+		time_sub ( &now, &start );
+	}
+	while ( now.sec == 0 && now.nsec < ms * 1000000 );
+}
+
+/* example periodic thread; every third job of second thread is too long */
+static void periodic_thread ( void *param )
+{
+	int thr_no = (int) param, job = 0;
+
+	while (1)
+	{
+		if ( thr_no == 1 && ++job % 3 == 0 )
+			work ( exec_ms[thr_no] * 2 );
+		else
+			work ( exec_ms[thr_no] );
+
+		wait_next_period ();
+	}
+}
+
+/* started (as new thread) when job misses its deadline */
+static void overrun_handler ( void *param )
+{
+	handled[(int) param]++;
+}
+
+int periodic ( char *args[] )
+{
+	thread_t thread[THR_NUM];
+	periodic_t info;
+	time_t period, deadline, wcet, sleep;
+	thread_t extra;
+	int i, retval;
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		handled[i] = 0;
+
+		period.sec = 0;
+		period.nsec = period_ms[i] * 1000000;
+		deadline.sec = 0;
+		deadline.nsec = deadline_ms[i] * 1000000;
+		wcet.sec = 0;
+		wcet.nsec = wcet_ms[i] * 1000000;
+
+		create_periodic_thread ( periodic_thread, (void *) i, SCHED_FIFO,
+					 THR_DEFAULT_PRIO + 1 + i, &period,
+					 &deadline, &wcet, overrun_handler,
+					 &thread[i] );
+	}
+
+	/* admission control: 95% more of processor can't be admitted */
+	period.sec = 0;
+	period.nsec = 20000000;
+	wcet.sec = 0;
+	wcet.nsec = 19000000;
+	retval = create_periodic_thread ( periodic_thread, (void *) 0,
+					  SCHED_FIFO, THR_DEFAULT_PRIO + 1,
+					  &period, NULL, &wcet, NULL, &extra );
+	print ( "Thread using 95%% of processor %s\n",
+		retval ? "rejected" : "admitted (error!)" );
+
+	print ( "Threads created, giving them %d seconds\n", TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		get_periodic_info ( &thread[i], &info );
+		print ( "Thread %d (period=%d ms, deadline=%d ms): jobs=%d, "
+			"overruns=%d, handled=%d\n", i, period_ms[i],
+			deadline_ms[i], info.jobs, info.overruns, handled[i] );
+	}
+
+	print ( "Test over - threads are to be canceled\n");
+
+	for ( i = 0; i < THR_NUM; i++ )
+		cancel_thread ( &thread[i] );
+	for ( i = 0; i < THR_NUM; i++ )
+		wait_for_thread ( &thread[i], IPC_WAIT );
+
+	return 0;
+}
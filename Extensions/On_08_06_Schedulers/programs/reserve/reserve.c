@@ -0,0 +1,89 @@
+/*! Processor reservation test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "Processor reservation demonstration example: several "
+		   "threads of process share its budget; compare iterations "
+		   "without reservation, with waiting and with demotion.";
+
+#define THR_NUM	4
+#define INNER_LOOP_COUNT 10000
+#define TEST_DURATION	2 /* seconds, for each test */
+
+static int iters[THR_NUM];
+
+/* example thread */
+static void busy_thread ( void *param )
+{
+	int j, thr_no;
+
+	thr_no = (int) param;
+
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		iters[thr_no]++;
+	}
+}
+
+/* run threads for TEST_DURATION, return their iterations */
+static int run_test ()
+{
+	thread_t thread[THR_NUM];
+	time_t sleep;
+	int i, sum;
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		iters[i] = 0;
+		create_thread ( busy_thread, (void *) i, SCHED_FIFO,
+				THR_DEFAULT_PRIO - 1, &thread[i] );
+	}
+
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+
+	for ( i = 0; i < THR_NUM; i++ )
+		cancel_thread ( &thread[i] );
+	for ( i = 0, sum = 0; i < THR_NUM; i++ )
+	{
+		wait_for_thread ( &thread[i], IPC_WAIT );
+		sum += iters[i];
+	}
+
+	return sum;
+}
+
+int reserve ( char *args[] )
+{
+	cpu_reserve_t res;
+
+	print ( "Without reservation: %d iterations\n", run_test () );
+
+	/* whole process (all its threads): 20 ms in each 100 ms */
+	res.budget.sec = 0;
+	res.budget.nsec = 20000000;
+	res.period.sec = 0;
+	res.period.nsec = 100000000;
+	res.flags = 0;
+	set_cpu_reserve ( NULL, &res );
+
+	print ( "With 20%% reservation: %d iterations\n", run_test () );
+
+	res.flags = RESERVE_DEMOTE;
+	set_cpu_reserve ( NULL, &res );
+
+	print ( "With 20%% reservation and demotion: %d iterations\n",
+		run_test () );
+
+	res.budget.sec = res.budget.nsec = 0;
+	set_cpu_reserve ( NULL, &res );
+
+	return 0;
+}
@@ -13,20 +13,32 @@ char PROG_HELP[] = "Thread demonstration example: create several threads that "
 #define TEST_DURATION	10 /* seconds */
 
 static int iters[THR_NUM];
+static int deferred[THR_NUM];
 
 /* example threads */
 static void rr_thread ( void *param )
 {
 	int i, j, thr_no;
+	volatile int hint = 0;
 
 	thr_no = (int) param;
 
+	/* inner loop is treated as critical section (e.g. under spin lock) */
+	set_preempt_hint ( &hint );
+
 	print ( "RR thread %d starting\n", thr_no );
 	for ( i = 1; ; i++ )
 	{
+		preempt_defer_begin ( &hint );
+
 		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
 			memory_barrier ();
 
+		if ( hint & PREEMPT_YIELD )
+			deferred[thr_no]++;
+
+		preempt_defer_end ( &hint );
+
 		iters[thr_no]++;
 	}
 	print ( "RR thread %d exiting\n", thr_no );
@@ -40,7 +52,7 @@ int round_robin ( char *args[] )
 
 	for ( i = 0; i < THR_NUM; i++ )
 	{
-		iters[i] = 0;
+		iters[i] = deferred[i] = 0;
 		create_thread ( rr_thread, (void *) i,
 				SCHED_RR, THR_DEFAULT_PRIO - 1, &thread[i] );
 	}
@@ -56,7 +68,8 @@ int round_robin ( char *args[] )
 	for ( i = 0; i < THR_NUM; i++ )
 		wait_for_thread ( &thread[i], IPC_WAIT );
 	for ( i = 0; i < THR_NUM; i++ )
-		print ( "Thread %d, count=%d\n", i, iters[i] );
+		print ( "Thread %d, count=%d, deferred preemptions=%d\n",
+			i, iters[i], deferred[i] );
 
 	return 0;
 }
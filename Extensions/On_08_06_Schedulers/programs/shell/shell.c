@@ -21,10 +21,12 @@ cmd_t;
 #define MAXARGS		10
 #define PROG_LIST_SIZE	1000
 #define INFO_SIZE	1000
+#define THR_INFO_SIZE	8192
 
 static int help ();
 static int clear ();
 static int sysinfo ( char *args[] );
+static int threads_info ( char *args[] );
 
 static cmd_t sh_cmd[] =
 {
@@ -166,9 +168,52 @@ static int sysinfo ( char *args[] )
 {
 	char info[INFO_SIZE];
 
+	if ( args[1] && strcmp ( args[1], "threads" ) == 0 )
+		return threads_info ( args );
+
 	syscall ( SYSINFO, &info, INFO_SIZE, args );
 
 	print ( "%s\n", info );
 
 	return 0;
 }
+
+/*! print statistics for all threads and processes */
+static int threads_info ( char *args[] )
+{
+	static char buffer[THR_INFO_SIZE];
+	static char *state[] = { "?", "active", "ready", "blocked", "finished" };
+	threads_info_t *info = (void *) buffer;
+	thread_info_t *ti;
+	process_info_t *pi;
+	int i;
+
+	if ( syscall ( SYSINFO, buffer, THR_INFO_SIZE, args ) )
+	{
+		print ( "Too many threads (%d) and processes (%d)\n",
+			info->threads, info->processes );
+		return -1;
+	}
+
+	print ( "Threads: %d, processes: %d\n", info->threads,
+		info->processes );
+	print ( "thread proc prio sched state    cpu  run[ms]  vol/invol\n" );
+
+	ti = (void *) ( info + 1 );
+	for ( i = 0; i < info->threads; i++, ti++ )
+		print ( "%d\t%d\t%d\t%d\t%s\t%d\t%d\t%d/%d\n",
+			ti->id, ti->proc_id, ti->prio, ti->sched_policy,
+			state[ti->state < 5 ? ti->state : 0], ti->cpu,
+			ti->run_time.sec * 1000 + ti->run_time.nsec / 1000000,
+			ti->voluntary, ti->involuntary );
+
+	print ( "process threads run[ms]  vol/invol\n" );
+
+	pi = (void *) ti;
+	for ( i = 0; i < info->processes; i++, pi++ )
+		print ( "%d\t%d\t%d\t%d/%d\n", pi->id, pi->threads,
+			pi->run_time.sec * 1000 + pi->run_time.nsec / 1000000,
+			pi->voluntary, pi->involuntary );
+
+	return 0;
+}
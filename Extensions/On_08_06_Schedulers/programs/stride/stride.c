@@ -0,0 +1,74 @@
+/*! Stride scheduler test example */
+
+#include <api/stdio.h>
+#include <api/thread.h>
+#include <api/time.h>
+#include <arch/processor.h>
+
+char PROG_HELP[] = "Stride scheduler demonstration example: create several "
+		   "threads with different number of tickets and count their "
+		   "iterations.";
+
+#define THR_NUM	3
+#define INNER_LOOP_COUNT 10000
+#define TEST_DURATION	5 /* seconds */
+
+static int iterations[THR_NUM];
+
+/* thread tickets (processor shares should be 1 : 2 : 3) */
+static int tickets[THR_NUM] = { 100, 200, 300 };
+
+/* example thread */
+static void stride_thread ( void *param )
+{
+	int j, thr_no;
+
+	thr_no = (int) param;
+
+	print ( "Stride thread %d starting (tickets=%d)\n", thr_no,
+		tickets[thr_no] );
+
+	while (1)
+	{
+		for ( j = 0; j < INNER_LOOP_COUNT; j++ )
+			memory_barrier ();
+
+		iterations[thr_no]++;
+	}
+}
+
+int stride ( char *args[] )
+{
+	thread_t thread[THR_NUM];
+	int i;
+	time_t sleep;
+	sched_t params;
+
+	for ( i = 0; i < THR_NUM; i++ )
+	{
+		iterations[i] = 0;
+		create_thread ( stride_thread, (void *) i, SCHED_STRIDE,
+				THR_DEFAULT_PRIO, &thread[i] );
+
+		params.stride.tickets = tickets[i];
+		params.stride.proc_tickets = 0;
+		params.stride.flags = 0;
+		set_sched_params ( &thread[i], SCHED_STRIDE, 0, &params );
+	}
+
+	print ( "Threads created, giving them %d seconds\n", TEST_DURATION );
+	sleep.sec = TEST_DURATION;
+	sleep.nsec = 0;
+	delay ( &sleep );
+	print ( "Test over - threads are to be canceled\n");
+
+	for ( i = 0; i < THR_NUM; i++ )
+		cancel_thread ( &thread[i] );
+	for ( i = 0; i < THR_NUM; i++ )
+		wait_for_thread ( &thread[i], IPC_WAIT );
+	for ( i = 0; i < THR_NUM; i++ )
+		print ( "Thread %d (tickets=%d), iterations=%d\n", i,
+			tickets[i], iterations[i] );
+
+	return 0;
+}